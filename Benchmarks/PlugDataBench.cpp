@@ -0,0 +1,581 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+// Headless DSP benchmark: loads every patch in a directory without an editor, and runs processBlock as fast as possible
+// Usage: plugdata_bench <patch directory> [--seconds 10] [--sample-rate 44100] [--block-sizes 64,256,1024] [--oversampling 0,1,2] [--channels 2,8] [--instances 8] [--voices 128] [--eager-libraries]
+// Results are printed as tab-separated lines: first the time and memory it takes to create plugin instances and the time it takes to load a patch with a cloned abstraction, the cost of moving audio in and out of pd, the block latency while another thread reads from pd objects, and the block latency while the GUI sends messages to pd objects, then one line per patch and configuration, followed by the time it takes to save and restore the plugin state of each patch
+// Pass --eager-libraries to set up all ELSE and cyclone classes right away, to compare with setting them up on first use
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#if JUCE_LINUX
+#    include <unistd.h>
+#elif JUCE_MAC
+#    include <mach/mach.h>
+#endif
+
+#include "PluginProcessor.h"
+
+// Counts C++ heap allocations made on the benchmark thread while inside processBlock
+// Pd allocates through getbytes/malloc, those allocations don't pass through here
+static std::atomic<int64> numAllocations = 0;
+static thread_local bool countAllocations = false;
+
+static void* countedAllocation(std::size_t size)
+{
+    if (countAllocations)
+        numAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto* ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return countedAllocation(size); }
+void* operator new[](std::size_t size) { return countedAllocation(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+struct BenchmarkConfig {
+    int blockSize;
+    int oversampling; // Same as PluginProcessor::oversampling, the factor is 1 << oversampling
+    int numChannels;
+};
+
+struct BenchmarkResult {
+    double samplesPerSecond = 0.0;
+    double realtimeFactor = 0.0;
+    double latencyPercentiles[3] = { 0.0 }; // p50, p90, p99 in microseconds
+    double maxLatency = 0.0;
+    double allocationsPerBlock = 0.0;
+};
+
+struct StateResult {
+    double firstSaveTime = 0.0; // milliseconds
+    double saveTime = 0.0;
+    double restoreTime = 0.0;
+    size_t stateSize = 0;
+};
+
+static Array<int> parseList(String const& text)
+{
+    StringArray tokens;
+    tokens.addTokens(text, ",", "");
+
+    Array<int> result;
+    for (auto const& token : tokens) {
+        if (token.trim().isNotEmpty())
+            result.add(token.getIntValue());
+    }
+    return result;
+}
+
+// Lets the processor deliver whatever it posted to the message thread
+static void runMessageLoop(int milliseconds)
+{
+    MessageManager::getInstance()->runDispatchLoopUntil(milliseconds);
+}
+
+// Resident memory of the process in kilobytes, or 0 on platforms where we don't read it
+static int64 getResidentMemory()
+{
+#if JUCE_LINUX
+    std::ifstream statm("/proc/self/statm");
+    int64 size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+#elif JUCE_MAC
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+        return static_cast<int64>(info.resident_size / 1024);
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+// Creates plugin instances the way a host would when loading a project with many plugdata instances
+// The first instance also initialises pd, the ones after that show what every extra instance costs
+static void runInstanceBenchmark(int numInstances)
+{
+    std::cout << "instance\tconstruction (ms)\tmemory (KB)" << std::endl;
+
+    std::vector<std::unique_ptr<PluginProcessor>> instances;
+    for (int i = 0; i < numInstances; i++) {
+        auto const memoryBefore = getResidentMemory();
+        auto const start = Time::getHighResolutionTicks();
+        instances.push_back(std::make_unique<PluginProcessor>());
+        auto const constructionTime = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0;
+
+        runMessageLoop(20);
+        std::cout << i << "\t" << constructionTime << "\t" << (getResidentMemory() - memoryBefore) << std::endl;
+    }
+
+    instances.clear();
+    runMessageLoop(100);
+    std::cout << std::endl;
+}
+
+// Loads a polyphonic patch, with one [clone] of an abstraction for every voice, a few times in a row
+// The first load reads and parses the abstraction once for all voices, the loads after that don't need to read it at all
+static void runCloneBenchmark(PluginProcessor& processor, int numVoices)
+{
+    auto const directory = File::createTempFile("plugdata_bench");
+    directory.createDirectory();
+
+    directory.getChildFile("voice.pd").replaceWithText("#N canvas 0 0 450 300 12;\n"
+                                                       "#X obj 20 20 inlet;\n"
+                                                       "#X obj 20 60 mtof;\n"
+                                                       "#X obj 20 100 osc~;\n"
+                                                       "#X obj 20 140 *~ 0.1;\n"
+                                                       "#X obj 20 180 outlet~;\n"
+                                                       "#X connect 0 0 1 0;\n"
+                                                       "#X connect 1 0 2 0;\n"
+                                                       "#X connect 2 0 3 0;\n"
+                                                       "#X connect 3 0 4 0;\n");
+
+    auto const patchFile = directory.getChildFile("clone.pd");
+    patchFile.replaceWithText("#N canvas 0 0 450 300 12;\n"
+                              "#X obj 20 20 clone voice " + String(numVoices) + ";\n"
+                              "#X obj 20 60 dac~;\n"
+                              "#X connect 0 0 1 0;\n"
+                              "#X connect 0 0 1 1;\n");
+
+    std::cout << "clone load\tvoices\tload (ms)" << std::endl;
+
+    for (int i = 0; i < 3; i++) {
+        auto const start = Time::getHighResolutionTicks();
+        auto patch = processor.loadPatch(patchFile, nullptr);
+        auto const loadTime = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0;
+
+        std::cout << i << "\t" << numVoices << "\t" << loadTime << std::endl;
+
+        processor.patches.clear();
+        patch = nullptr;
+        runMessageLoop(50);
+    }
+
+    std::cout << std::endl;
+    directory.deleteRecursively();
+}
+
+static BenchmarkResult runBenchmark(PluginProcessor& processor, BenchmarkConfig const& config, double sampleRate, double seconds)
+{
+    processor.setPlayConfigDetails(config.numChannels, config.numChannels, sampleRate, config.blockSize);
+    // Don't use setOversampling here, that would write to the user's settings file
+    processor.oversampling = config.oversampling;
+    processor.prepareToPlay(sampleRate, config.blockSize);
+
+    AudioBuffer<float> input(config.numChannels, config.blockSize);
+    AudioBuffer<float> buffer(config.numChannels, config.blockSize);
+    MidiBuffer midiBuffer;
+
+    Random random(1);
+    for (int ch = 0; ch < config.numChannels; ch++) {
+        for (int i = 0; i < config.blockSize; i++) {
+            input.setSample(ch, i, random.nextFloat() * 0.5f - 0.25f);
+        }
+    }
+
+    auto const numBlocks = std::max(1, roundToInt(sampleRate * seconds / config.blockSize));
+    auto const numWarmupBlocks = std::max(1, roundToInt(sampleRate / config.blockSize));
+
+    // Let loadbangs, allocations on first use and caches settle before measuring
+    for (int block = 0; block < numWarmupBlocks; block++) {
+        buffer.makeCopyOf(input, true);
+        processor.processBlock(buffer, midiBuffer);
+        midiBuffer.clear();
+    }
+
+    std::vector<double> blockTimes(numBlocks);
+    double totalTime = 0.0;
+    numAllocations = 0;
+
+    for (int block = 0; block < numBlocks; block++) {
+        buffer.makeCopyOf(input, true);
+
+        countAllocations = true;
+        auto const start = Time::getHighResolutionTicks();
+        processor.processBlock(buffer, midiBuffer);
+        auto const end = Time::getHighResolutionTicks();
+        countAllocations = false;
+
+        midiBuffer.clear();
+
+        blockTimes[block] = Time::highResolutionTicksToSeconds(end - start);
+        totalTime += blockTimes[block];
+    }
+
+    processor.releaseResources();
+
+    std::sort(blockTimes.begin(), blockTimes.end());
+    auto percentile = [&blockTimes](double fraction) {
+        auto const index = std::min(blockTimes.size() - 1, static_cast<size_t>(fraction * blockTimes.size()));
+        return blockTimes[index] * 1e6;
+    };
+
+    BenchmarkResult result;
+    result.samplesPerSecond = totalTime > 0.0 ? (static_cast<double>(numBlocks) * config.blockSize) / totalTime : 0.0;
+    result.realtimeFactor = result.samplesPerSecond / sampleRate;
+    result.latencyPercentiles[0] = percentile(0.5);
+    result.latencyPercentiles[1] = percentile(0.9);
+    result.latencyPercentiles[2] = percentile(0.99);
+    result.maxLatency = blockTimes.back() * 1e6;
+    result.allocationsPerBlock = static_cast<double>(numAllocations.load()) / numBlocks;
+    return result;
+}
+
+// Runs empty Pd blocks, so the time is mostly spent moving audio in and out of pd
+// "process_raw" is how blocks used to be processed: the host channels are copied into one buffer, which libpd_process_raw copies into Pd's sound buffers, and back the same way
+// "direct" copies the host channels straight into Pd's sound buffers and back, like processConstant does, and "in place" doesn't copy at all, like processVariable, where the FIFOs fill Pd's sound buffers
+static void runBlockCopyBenchmark(PluginProcessor& processor, double sampleRate, double seconds)
+{
+    auto const blockSize = pd::Instance::getBlockSize();
+
+    std::cout << "block copies\tchannels\tblocks/s\tchannel copies/s" << std::endl;
+
+    for (auto numChannels : { 2, 16, 64 }) {
+        processor.setThis();
+        processor.prepareDSP(numChannels, numChannels, sampleRate, blockSize);
+        processor.startDSP();
+
+        AudioBuffer<float> buffer(numChannels, blockSize);
+        buffer.clear();
+        std::vector<float> interleaved(numChannels * blockSize);
+
+        for (auto const* mode : { "process_raw", "direct", "in place" }) {
+            auto const& soundInputs = processor.getSoundInputs();
+            auto const& soundOutputs = processor.getSoundOutputs();
+
+            int64 numBlocks = 0;
+            auto const start = Time::getMillisecondCounterHiRes();
+            auto const end = start + seconds * 1000.0;
+            while (Time::getMillisecondCounterHiRes() < end) {
+                for (int block = 0; block < 256; block++) {
+                    if (String(mode) == "process_raw") {
+                        for (int ch = 0; ch < numChannels; ch++)
+                            FloatVectorOperations::copy(interleaved.data() + ch * blockSize, buffer.getReadPointer(ch), blockSize);
+                        processor.setThis();
+                        libpd_process_raw(interleaved.data(), interleaved.data());
+                        for (int ch = 0; ch < numChannels; ch++)
+                            FloatVectorOperations::copy(buffer.getWritePointer(ch), interleaved.data() + ch * blockSize, blockSize);
+                    } else if (String(mode) == "direct") {
+                        for (int ch = 0; ch < numChannels; ch++)
+                            FloatVectorOperations::copy(soundInputs[ch], buffer.getReadPointer(ch), blockSize);
+                        processor.performDSP();
+                        for (int ch = 0; ch < numChannels; ch++)
+                            FloatVectorOperations::copy(buffer.getWritePointer(ch), soundOutputs[ch], blockSize);
+                    } else {
+                        processor.performDSP();
+                    }
+                }
+                numBlocks += 256;
+            }
+            auto const elapsed = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+            auto const copiesPerBlock = String(mode) == "process_raw" ? 4 * numChannels : (String(mode) == "direct" ? 2 * numChannels : 0);
+            std::cout << mode << "\t" << numChannels << "\t" << (static_cast<double>(numBlocks) / elapsed) << "\t"
+                      << (static_cast<double>(numBlocks * copiesPerBlock) / elapsed) << std::endl;
+        }
+
+        processor.releaseDSP();
+    }
+
+    std::cout << std::endl;
+}
+
+// Runs the audio thread while another thread keeps polling objects the way animated GUIs do, once with get() and once with peek()
+// get() takes the pd lock for every read, so it shows up in the block latency, peek() only publishes the object it reads
+// A patch with 64 oscillators, each with a number box next to it, for the benchmarks that talk to pd objects from the GUI
+static File createObjectPatch()
+{
+    auto const patchFile = File::createTempFile("pd");
+
+    String content = "#N canvas 0 0 450 300 12;\n";
+    for (int i = 0; i < 64; i++) {
+        auto const y = String(i * 40);
+        content << "#X obj 20 " << y << " osc~ " << String(110 + i * 10) << ";\n"
+                << "#X obj 120 " << y << " *~ 0.01;\n"
+                << "#X obj 220 " << y << " nbx 5 14 -1e+37 1e+37 0 0 empty empty empty 0 -8 0 10 #fcfcfc #000000 #000000 0 256;\n";
+    }
+    content << "#X obj 20 2600 dac~;\n";
+    for (int i = 0; i < 64; i++) {
+        content << "#X connect " << String(i * 3) << " 0 " << String(i * 3 + 1) << " 0;\n"
+                << "#X connect " << String(i * 3 + 1) << " 0 192 0;\n";
+    }
+    patchFile.replaceWithText(content);
+    return patchFile;
+}
+
+static void runContentionBenchmark(PluginProcessor& processor, double sampleRate, double seconds)
+{
+    auto const patchFile = createObjectPatch();
+    auto patch = processor.loadPatch(patchFile, nullptr);
+    if (!patch) {
+        patchFile.deleteFile();
+        return;
+    }
+
+    runMessageLoop(50);
+    auto const objects = patch->getObjects();
+
+    std::cout << "contention\treads/s\tp50 (us)\tp99 (us)\tmax (us)" << std::endl;
+
+    for (auto const* mode : { "none", "get", "peek" }) {
+        std::atomic<bool> running = true;
+        std::atomic<int64> numReads = 0;
+
+        std::thread reader([&, mode]() {
+            if (String(mode) == "none")
+                return;
+
+            int64 sum = 0;
+            while (running) {
+                for (auto const& object : objects) {
+                    if (String(mode) == "get") {
+                        if (auto obj = object.get<t_text>())
+                            sum += obj->te_xpix;
+                    } else if (auto obj = object.peek<t_text>()) {
+                        sum += obj->te_xpix;
+                    }
+                }
+                numReads += static_cast<int64>(objects.size());
+            }
+
+            ignoreUnused(sum);
+        });
+
+        auto const start = Time::getMillisecondCounterHiRes();
+        auto const result = runBenchmark(processor, { 64, 0, 2 }, sampleRate, seconds);
+        auto const elapsed = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+        running = false;
+        reader.join();
+
+        std::cout << mode << "\t" << (static_cast<double>(numReads.load()) / elapsed) << "\t"
+                  << result.latencyPercentiles[0] << "\t" << result.latencyPercentiles[2] << "\t" << result.maxLatency << std::endl;
+    }
+
+    std::cout << std::endl;
+
+    processor.patches.clear();
+    patch = nullptr;
+    runMessageLoop(50);
+    patchFile.deleteFile();
+}
+
+// Runs the audio thread while the message thread keeps sending direct messages to number boxes, the way dragging a slider does
+// "queued" messages are delivered at the start of the next block, "locked" ones are sent while holding the pd lock and delivered right away
+static void runDirectMessageBenchmark(PluginProcessor& processor, double sampleRate, double seconds)
+{
+    auto const patchFile = createObjectPatch();
+    auto patch = processor.loadPatch(patchFile, nullptr);
+    if (!patch) {
+        patchFile.deleteFile();
+        return;
+    }
+
+    runMessageLoop(50);
+
+    std::vector<pd::WeakReference> numberBoxes;
+    auto const objects = patch->getObjects();
+    for (size_t i = 2; i < objects.size(); i += 3) {
+        numberBoxes.push_back(objects[i]);
+    }
+
+    std::cout << "direct messages\tmessages/s\tp50 (us)\tp99 (us)\tmax (us)" << std::endl;
+
+    for (auto const* mode : { "none", "queued", "locked" }) {
+        std::atomic<bool> running = true;
+        BenchmarkResult result;
+
+        std::thread audioThread([&]() {
+            result = runBenchmark(processor, { 64, 0, 2 }, sampleRate, seconds);
+            running = false;
+        });
+
+        int64 numMessages = 0;
+        auto const start = Time::getMillisecondCounterHiRes();
+        while (running && String(mode) != "none") {
+            for (auto const& numberBox : numberBoxes) {
+                auto const value = static_cast<float>(numMessages % 128);
+                if (String(mode) == "queued") {
+                    processor.sendDirectMessage(numberBox, value);
+                } else if (auto obj = numberBox.get<void>()) {
+                    processor.sendDirectMessage(numberBox, value);
+                }
+                numMessages++;
+            }
+
+            // Give the message thread some air, like a GUI would between mouse events
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        auto const elapsed = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+        audioThread.join();
+
+        std::cout << mode << "\t" << (elapsed > 0.0 ? static_cast<double>(numMessages) / elapsed : 0.0) << "\t"
+                  << result.latencyPercentiles[0] << "\t" << result.latencyPercentiles[2] << "\t" << result.maxLatency << std::endl;
+    }
+
+    std::cout << std::endl;
+
+    processor.patches.clear();
+    patch = nullptr;
+    runMessageLoop(50);
+    patchFile.deleteFile();
+}
+
+// Measures getStateInformation and setStateInformation, the way a host would call them when saving a project or browsing presets
+static StateResult runStateBenchmark(PluginProcessor& processor, int iterations)
+{
+    auto const toMilliseconds = [](int64 ticks) {
+        return Time::highResolutionTicksToSeconds(ticks) * 1000.0;
+    };
+
+    // Make sure the first save has to compress everything
+    for (auto& patch : processor.patches) {
+        patch->stateHash = 0;
+        patch->stateData.reset();
+    }
+
+    StateResult result;
+    MemoryBlock state;
+
+    auto start = Time::getHighResolutionTicks();
+    processor.getStateInformation(state);
+    result.firstSaveTime = toMilliseconds(Time::getHighResolutionTicks() - start);
+    result.stateSize = state.getSize();
+
+    for (int i = 0; i < iterations; i++) {
+        MemoryBlock block;
+        start = Time::getHighResolutionTicks();
+        processor.getStateInformation(block);
+        result.saveTime += toMilliseconds(Time::getHighResolutionTicks() - start);
+    }
+
+    for (int i = 0; i < iterations; i++) {
+        start = Time::getHighResolutionTicks();
+        processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+        result.restoreTime += toMilliseconds(Time::getHighResolutionTicks() - start);
+        runMessageLoop(10);
+    }
+
+    result.saveTime /= iterations;
+    result.restoreTime /= iterations;
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto arguments = StringArray(argv + 1, argc - 1);
+
+    auto getOption = [&arguments](String const& name, String const& defaultValue) {
+        auto index = arguments.indexOf(name);
+        if (index >= 0 && index + 1 < arguments.size())
+            return arguments[index + 1];
+        return defaultValue;
+    };
+
+    auto const patchDirectory = arguments.isEmpty() ? File() : File::getCurrentWorkingDirectory().getChildFile(arguments[0]);
+    if (!patchDirectory.isDirectory()) {
+        std::cerr << "Usage: plugdata_bench <patch directory> [--seconds 10] [--sample-rate 44100] [--block-sizes 64,256,1024] [--oversampling 0,1,2] [--channels 2,8] [--instances 8] [--voices 128] [--eager-libraries]" << std::endl;
+        return 1;
+    }
+
+    auto const seconds = getOption("--seconds", "10").getDoubleValue();
+    auto const sampleRate = getOption("--sample-rate", "44100").getDoubleValue();
+    auto const blockSizes = parseList(getOption("--block-sizes", "64,256,1024"));
+    auto const oversamplingFactors = parseList(getOption("--oversampling", "0,1,2"));
+    auto const channelCounts = parseList(getOption("--channels", "2,8"));
+    auto const numInstances = getOption("--instances", "8").getIntValue();
+    auto const numVoices = getOption("--voices", "128").getIntValue();
+    pd::Instance::lazyLibraries = !arguments.contains("--eager-libraries");
+
+    auto patchFiles = patchDirectory.findChildFiles(File::findFiles, false, "*.pd");
+    patchFiles.sort();
+
+    if (patchFiles.isEmpty()) {
+        std::cerr << "No patches found in " << patchDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    runInstanceBenchmark(numInstances);
+
+    auto processor = std::make_unique<PluginProcessor>();
+    runMessageLoop(100);
+
+    runCloneBenchmark(*processor, numVoices);
+    runBlockCopyBenchmark(*processor, sampleRate, std::min(seconds, 2.0));
+    runContentionBenchmark(*processor, sampleRate, std::min(seconds, 5.0));
+    runDirectMessageBenchmark(*processor, sampleRate, std::min(seconds, 5.0));
+
+    std::cout << "patch\tblock size\toversampling\tchannels\tsamples/s\trealtime factor\tp50 (us)\tp90 (us)\tp99 (us)\tmax (us)\tallocations/block" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    StringArray stateResults;
+    int failures = 0;
+    for (auto const& patchFile : patchFiles) {
+        auto patch = processor->loadPatch(patchFile, nullptr);
+        if (!patch) {
+            std::cerr << "Couldn't open " << patchFile.getFullPathName() << std::endl;
+            failures++;
+            continue;
+        }
+
+        runMessageLoop(50);
+
+        for (auto blockSize : blockSizes) {
+            for (auto oversampling : oversamplingFactors) {
+                for (auto numChannels : channelCounts) {
+                    auto const config = BenchmarkConfig { blockSize, oversampling, numChannels };
+                    auto const result = runBenchmark(*processor, config, sampleRate, seconds);
+
+                    std::cout << patchFile.getFileName() << "\t" << blockSize << "\t" << (1 << oversampling) << "x\t" << numChannels << "\t"
+                              << result.samplesPerSecond << "\t" << result.realtimeFactor << "\t"
+                              << result.latencyPercentiles[0] << "\t" << result.latencyPercentiles[1] << "\t" << result.latencyPercentiles[2] << "\t"
+                              << result.maxLatency << "\t" << result.allocationsPerBlock << std::endl;
+
+                    runMessageLoop(10);
+                }
+            }
+        }
+
+        auto const state = runStateBenchmark(*processor, 20);
+        stateResults.add(patchFile.getFileName() + "\t" + String(state.firstSaveTime, 3) + "\t" + String(state.saveTime, 3) + "\t" + String(state.restoreTime, 3) + "\t" + String(state.stateSize));
+
+        // Releasing the last reference closes the patch, restoring the state may have replaced the one we opened
+        processor->patches.clear();
+        patch = nullptr;
+        runMessageLoop(50);
+    }
+
+    std::cout << std::endl
+              << "patch\tfirst save (ms)\tsave (ms)\trestore (ms)\tstate size (bytes)" << std::endl;
+    for (auto const& line : stateResults) {
+        std::cout << line << std::endl;
+    }
+
+    processor.reset();
+    return failures > 0 ? 1 : 0;
+}
@@ -431,6 +431,24 @@ void Canvas::synchronise()
     triggerAsyncUpdate();
 }
 
+void Canvas::objectChanged(void* ptr)
+{
+    changedObjects.insert(ptr);
+}
+
+// Pd selects the objects that an undo or redo changed, so those are the ones to update
+void Canvas::markSelectionChanged()
+{
+    if (auto cnv = patch.getPointer()) {
+        if (!cnv->gl_editor)
+            return;
+
+        for (auto* selection = cnv->gl_editor->e_selection; selection; selection = selection->sel_next) {
+            changedObjects.insert(selection->sel_what);
+        }
+    }
+}
+
 void Canvas::synchroniseSplitCanvas()
 {
     for (auto split : editor->splitView.splits) {
@@ -442,15 +460,26 @@ void Canvas::synchroniseSplitCanvas()
 
 // Synchronise state with pure-data
 // Used for loading and for complicated actions like undo/redo
+// Only objects that are new, that changed bounds or iolets, or that were marked as changed get their GUI updated
 void Canvas::performSynchronise()
 {
     pd->lockAudioThread();
 
     patch.setCurrent();
+    pd->flushDirectMessages();
     pd->sendMessagesFromQueue();
 
     pd->unlockAudioThread();
 
+    auto pdObjects = patch.getObjects();
+
+    // Index the current pd state once, so every lookup below is O(1)
+    std::unordered_set<void*> pdObjectPointers;
+    pdObjectPointers.reserve(pdObjects.size());
+    for (auto& object : pdObjects) {
+        pdObjectPointers.insert(object.getRawUnchecked<void>());
+    }
+
     // Remove deleted connections
     for (int n = connections.size() - 1; n >= 0; n--) {
         if (!connections[n]->getPointer()) {
@@ -463,7 +492,7 @@ void Canvas::performSynchronise()
         auto* object = objects[n];
 
         // If the object is showing it's initial editor, meaning no object was assigned yet, allow it to exist without pointing to an object
-        if ((!object->getPointer() || patch.objectWasDeleted(object->getPointer())) && !object->isInitialEditorShown()) {
+        if ((!object->getPointer() || !pdObjectPointers.contains(object->getPointer())) && !object->isInitialEditorShown()) {
             setSelected(object, false, false);
             objects.remove(n);
         }
@@ -476,43 +505,84 @@ void Canvas::performSynchronise()
         }
     }
 
-    auto pdObjects = patch.getObjects();
+    std::unordered_map<void*, Object*> objectsByPointer;
+    objectsByPointer.reserve(objects.size());
+    for (auto* object : objects) {
+        if (auto* ptr = object->getPointer())
+            objectsByPointer[ptr] = object;
+    }
+
+    auto previousOrder = std::vector<Object*>(objects.begin(), objects.end());
 
-    for (auto object : pdObjects) {
-        auto* it = std::find_if(objects.begin(), objects.end(), [&object](Object* b) { return b->getPointer() && b->getPointer() == object.getRawUnchecked<void>(); });
+    // Build the new object order in a single pass over the pd objects
+    // Objects that don't point to a pd object yet stay at the end, like before
+    std::vector<Object*> orderedObjects;
+    std::unordered_set<Object*> placedObjects;
+    orderedObjects.reserve(objects.size() + pdObjects.size());
+
+    for (auto& object : pdObjects) {
         if (!object.isValid())
             continue;
 
-        if (it == objects.end()) {
+        auto it = objectsByPointer.find(object.getRawUnchecked<void>());
+        if (it == objectsByPointer.end()) {
             auto* newBox = objects.add(new Object(object, this));
+            newBox->updateSyncState();
             newBox->toFront(false);
 
             // TODO: don't do this on Canvas!!
             if (newBox->gui && newBox->gui->getLabel())
                 newBox->gui->getLabel()->toFront(false);
+
+            objectsByPointer[newBox->getPointer()] = newBox;
+            orderedObjects.push_back(newBox);
+            placedObjects.insert(newBox);
         } else {
-            auto* object = *it;
+            auto* object = it->second;
 
-            // Check if number of inlets/outlets is correct
-            object->updateIolets();
-            object->updateBounds();
+            auto needsUpdate = changedObjects.contains(it->first);
 
-            object->toFront(false);
-            if (object->gui && object->gui->getLabel())
-                object->gui->getLabel()->toFront(false);
-            if (object->gui)
+            // Only update the iolets and bounds of objects where those changed since the last sync
+            if (object->updateSyncState()) {
+                // Check if number of inlets/outlets is correct
+                object->updateIolets();
+                object->updateBounds();
+                needsUpdate = true;
+            }
+
+            if (needsUpdate && object->gui)
                 object->gui->update();
+
+            orderedObjects.push_back(object);
+            placedObjects.insert(object);
         }
     }
 
+    for (auto* object : objects) {
+        if (!placedObjects.contains(object))
+            orderedObjects.push_back(object);
+    }
+
+    changedObjects.clear();
+
     // Make sure objects have the same order
-    std::sort(objects.begin(), objects.end(),
-        [&pdObjects](Object* first, Object* second) mutable {
-            size_t idx1 = std::find(pdObjects.begin(), pdObjects.end(), first->getPointer()) - pdObjects.begin();
-            size_t idx2 = std::find(pdObjects.begin(), pdObjects.end(), second->getPointer()) - pdObjects.begin();
+    jassert(orderedObjects.size() == objects.size());
+    std::copy(orderedObjects.begin(), orderedObjects.end(), objects.begin());
 
-            return idx1 < idx2;
-        });
+    // New objects were already brought to front above, so we only need to restack everything if existing objects moved
+    if (!std::equal(previousOrder.begin(), previousOrder.end(), orderedObjects.begin())) {
+        for (auto* object : objects) {
+            object->toFront(false);
+            if (object->gui && object->gui->getLabel())
+                object->gui->getLabel()->toFront(false);
+        }
+    }
+
+    std::unordered_map<t_outconnect*, Connection*> connectionsByPointer;
+    connectionsByPointer.reserve(connections.size());
+    for (auto* connection : connections) {
+        connectionsByPointer[connection->getPointer()] = connection;
+    }
 
     auto pdConnections = patch.getConnections();
 
@@ -522,25 +592,21 @@ void Canvas::performSynchronise()
         Iolet *inlet = nullptr, *outlet = nullptr;
 
         // Find the objects that this connection is connected to
-        for (auto* obj : objects) {
-            if (outobj && &outobj->te_g == obj->getPointer()) {
+        auto outIt = outobj ? objectsByPointer.find(&outobj->te_g) : objectsByPointer.end();
+        auto inIt = inobj ? objectsByPointer.find(&inobj->te_g) : objectsByPointer.end();
 
-                // Check if we have enough outlets, should never return false
-                if (isPositiveAndBelow(obj->numInputs + outno, obj->iolets.size())) {
-                    outlet = obj->iolets[obj->numInputs + outno];
-                } else {
-                    break;
-                }
-            }
-            if (inobj && &inobj->te_g == obj->getPointer()) {
+        // Check if we have enough outlets, should never return false
+        if (outIt != objectsByPointer.end()) {
+            auto* obj = outIt->second;
+            if (isPositiveAndBelow(obj->numInputs + outno, obj->iolets.size()))
+                outlet = obj->iolets[obj->numInputs + outno];
+        }
 
-                // Check if we have enough inlets, should never return false
-                if (isPositiveAndBelow(inno, obj->iolets.size())) {
-                    inlet = obj->iolets[inno];
-                } else {
-                    break;
-                }
-            }
+        // Check if we have enough inlets, should never return false
+        if (inIt != objectsByPointer.end()) {
+            auto* obj = inIt->second;
+            if (isPositiveAndBelow(inno, obj->iolets.size()))
+                inlet = obj->iolets[inno];
         }
 
         // This shouldn't be necessary, but just to be sure...
@@ -549,21 +615,18 @@ void Canvas::performSynchronise()
             continue;
         }
 
-        auto* it = std::find_if(connections.begin(), connections.end(),
-            [c_ptr = ptr](auto* c) {
-                return c_ptr == c->getPointer();
-            });
+        auto it = connectionsByPointer.find(ptr);
 
-        if (it == connections.end()) {
+        if (it == connectionsByPointer.end()) {
             connections.add(new Connection(this, inlet, outlet, ptr));
         } else {
-            auto& c = *(*it);
+            auto& c = *it->second;
 
             // This is necessary to make resorting a subpatchers iolets work
             // And it can't hurt to check if the connection is valid anyway
             if (c.inlet != inlet || c.outlet != outlet) {
-                int idx = connections.indexOf(*it);
-                connections.removeObject(*it);
+                int idx = connections.indexOf(it->second);
+                connections.removeObject(it->second);
                 connections.insert(idx, new Connection(this, inlet, outlet, ptr));
             } else {
                 c.popPathState();
@@ -581,6 +644,7 @@ void Canvas::performSynchronise()
     editor->updateCommandStatus();
     repaint();
     
+    pd->patchSearchIndex.invalidate(patch.getPointer().get());
     needsSearchUpdate = true;
 
     pd->updateObjectImplementations();
@@ -1614,6 +1678,7 @@ void Canvas::undo()
 {
     // Tell pd to undo the last action
     patch.undo();
+    markSelectionChanged();
 
     // Load state from pd
     synchronise();
@@ -1629,6 +1694,7 @@ void Canvas::redo()
 {
     // Tell pd to undo the last action
     patch.redo();
+    markSelectionChanged();
 
     // Load state from pd
     synchronise();
@@ -1886,7 +1952,7 @@ bool Canvas::panningModifierDown()
     return KeyPress::isKeyCurrentlyDown(KeyPress::spaceKey) || ModifierKeys::getCurrentModifiersRealtime().isMiddleButtonDown();
 }
 
-void Canvas::receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms)
+void Canvas::receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms)
 {
     switch (hash(symbol->s_name)) {
     case hash("obj"):
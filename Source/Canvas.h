@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <unordered_set>
+
 #include "ObjectGrid.h"          // move to impl
 #include "Utility/RateReducer.h" // move to impl
 #include "Utility/ModifierKeyListener.h"
@@ -81,6 +83,9 @@ public:
     void performSynchronise();
     void handleAsyncUpdate() override;
 
+    // Lets the GUI of this pd object read its state again on the next sync
+    void objectChanged(void* ptr);
+
     void moveToWindow(PluginEditor* newWindow);
 
     void updateDrawables();
@@ -138,7 +143,7 @@ public:
 
     ObjectParameters& getInspectorParameters();
 
-    void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) override;
+    void receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms) override;
 
     template<typename T>
     Array<T*> getSelectionOfType()
@@ -220,6 +225,11 @@ private:
 
     RateReducer canvasRateReducer = RateReducer(90);
 
+    void markSelectionChanged();
+
+    // Pd objects whose GUI should be updated on the next sync, besides new objects and objects whose bounds or iolets changed
+    std::unordered_set<void*> changedObjects;
+
     // Properties that can be shown in the inspector by right-clicking on canvas
     ObjectParameters parameters;
 
@@ -499,7 +499,7 @@ void Connection::mouseMove(MouseEvent const& e)
 
 StringArray Connection::getMessageFormated()
 {
-    auto args = lastValue;
+    auto const& args = lastValue;
     auto name = lastSelector ? String::fromUTF8(lastSelector->s_name) : "";
 
     StringArray formatedMessage;
@@ -511,30 +511,31 @@ StringArray Connection::getMessageFormated()
         formatedMessage.add("symbol:");
         formatedMessage.add(args[0].toString());
     } else if (name == "list") {
-        if (lastNumArgs >= 8) {
-            formatedMessage.add("list (7+):");
-        } else {
-            formatedMessage.add("list (" + String(lastNumArgs) + "):");
-        }
-        for (int arg = 0; arg < lastNumArgs; arg++) {
+        formatedMessage.add("list (" + String(lastNumArgs) + "):");
+
+        // Only show the start of long lists
+        for (int arg = 0; arg < std::min(lastNumArgs, 8); arg++) {
             if (args[arg].isFloat()) {
                 formatedMessage.add(String(args[arg].getFloat()));
             } else if (args[arg].isSymbol()) {
                 formatedMessage.add(args[arg].toString());
             }
         }
-        if (lastNumArgs >= 8) {
+        if (lastNumArgs > 8) {
             formatedMessage.add("...");
         }
     } else {
         formatedMessage.add(name);
-        for (int arg = 0; arg < lastNumArgs; arg++) {
+        for (int arg = 0; arg < std::min(lastNumArgs, 8); arg++) {
             if (args[arg].isFloat()) {
                 formatedMessage.add(String(args[arg].getFloat()));
             } else if (args[arg].isSymbol()) {
                 formatedMessage.add(args[arg].toString());
             }
         }
+        if (lastNumArgs > 8) {
+            formatedMessage.add("...");
+        }
     }
     return formatedMessage;
 }
@@ -866,22 +867,6 @@ int Connection::getMultiConnectNumber()
     return -1;
 }
 
-int Connection::getSignalData(t_float* output, int maxChannels)
-{
-    if (auto oc = ptr.get<t_outconnect>()) {
-        if (auto* signal = outconnect_get_signal(oc.get())) {
-            auto numChannels = std::min(signal->s_nchans, maxChannels);
-            auto* samples = signal->s_vec;
-            if (!samples)
-                return 0;
-            std::copy(samples, samples + (DEFDACBLKSIZE * numChannels), output);
-            return numChannels;
-        }
-    }
-
-    return 0;
-}
-
 int Connection::getNumSignalChannels()
 {
     if (auto oc = ptr.get<t_outconnect>()) {
@@ -1234,13 +1219,13 @@ void ConnectionPathUpdater::timerCallback()
     canvas->patch.endUndoSequence("SetConnectionPaths");
 }
 
-void Connection::receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms)
+void Connection::receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms)
 {
     // TODO: indicator
     // messageActivity = messageActivity >= 12 ? 0 : messageActivity + 1;
 
     outobj->triggerOverlayActiveState();
-    std::copy(atoms, atoms + numAtoms, lastValue);
+    lastValue.assign(atoms, atoms + numAtoms);
     lastNumArgs = numAtoms;
     lastSelector = symbol;
 }
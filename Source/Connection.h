@@ -22,6 +22,98 @@ using PathPlan = std::vector<Point<float>>;
 class Canvas;
 class PathUpdater;
 
+// Lets the GUI inspect the signal going through a connection
+// The message thread asks for a capture, the audio thread then copies the next captureSize samples and keeps the min, max and sum of squares of every block
+// Until the message thread has read the capture and asked for the next one, the audio thread only checks a flag
+class SignalProbe {
+public:
+    static constexpr int maxChannels = 8;
+    static constexpr int captureSize = 1024;
+
+    struct Summary {
+        float min = 0.0f;
+        float max = 0.0f;
+        float rms = 0.0f;
+    };
+
+    SignalProbe(t_outconnect* connection, pd::Instance* instance)
+        : outconnect(connection, instance)
+    {
+    }
+
+    // Audio thread, called while pd is locked, so the connection and its signal can't be freed while we read them
+    void process()
+    {
+        if (captureReady.load(std::memory_order_acquire) || !outconnect.isValid())
+            return;
+
+        auto* signal = outconnect_get_signal(outconnect.getRawUnchecked<t_outconnect>());
+        if (!signal || !signal->s_vec)
+            return;
+
+        auto const numChannels = std::min(signal->s_nchans, maxChannels);
+        auto const numSamples = std::min(signal->s_n, captureSize - numCaptured);
+
+        for (int ch = 0; ch < numChannels; ch++) {
+            auto const* samples = signal->s_vec + (ch * signal->s_n);
+            auto& summary = summaries[ch];
+            if (numCaptured == 0) {
+                summary.min = samples[0];
+                summary.max = samples[0];
+                sumOfSquares[ch] = 0.0f;
+            }
+
+            for (int i = 0; i < numSamples; i++) {
+                auto const sample = samples[i];
+                summary.min = std::min(summary.min, sample);
+                summary.max = std::max(summary.max, sample);
+                sumOfSquares[ch] += sample * sample;
+                capture[ch][numCaptured + i] = sample;
+            }
+        }
+
+        capturedChannels = numChannels;
+        numCaptured += numSamples;
+
+        if (numCaptured == captureSize) {
+            for (int ch = 0; ch < numChannels; ch++) {
+                summaries[ch].rms = std::sqrt(sumOfSquares[ch] / captureSize);
+            }
+            captureReady.store(true, std::memory_order_release);
+        }
+    }
+
+    // Message thread: copies the finished capture into the destination channels, and asks for the next one
+    // Returns the number of channels that were copied, or -1 if the audio thread hasn't finished the capture yet
+    int read(float (*destination)[captureSize], Summary* destinationSummaries, int numDestinationChannels)
+    {
+        if (!captureReady.load(std::memory_order_acquire))
+            return -1;
+
+        auto const numChannels = std::min(capturedChannels, numDestinationChannels);
+        for (int ch = 0; ch < numChannels; ch++) {
+            std::copy(capture[ch], capture[ch] + captureSize, destination[ch]);
+            destinationSummaries[ch] = summaries[ch];
+        }
+
+        numCaptured = 0;
+        captureReady.store(false, std::memory_order_release);
+        return numChannels;
+    }
+
+private:
+    pd::WeakReference outconnect;
+
+    // Only written by the audio thread while captureReady is false, and only read by the message thread while it's true
+    float capture[maxChannels][captureSize] = {};
+    Summary summaries[maxChannels];
+    float sumOfSquares[maxChannels] = {};
+    int numCaptured = 0;
+    int capturedChannels = 0;
+
+    std::atomic<bool> captureReady = false;
+};
+
 class Connection : public Component
     , public ComponentListener
     , public Value::Listener
@@ -110,12 +202,11 @@ public:
     bool intersectsObject(Object* object) const;
     bool straightLineIntersectsObject(Line<float> toCheck, Array<Object*>& objects);
 
-    void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) override;
+    void receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms) override;
 
     bool isSelected() const;
 
     StringArray getMessageFormated();
-    int getSignalData(t_float* output, int maxChannels);
 
 private:
     void resizeToFit();
@@ -154,7 +245,7 @@ private:
 
     pd::WeakReference ptr;
 
-    pd::Atom lastValue[8];
+    std::vector<pd::Atom> lastValue;
     int lastNumArgs = 0;
     t_symbol* lastSelector = nullptr;
 
@@ -28,9 +28,10 @@ public:
         setBufferedToImage(true);
     }
 
-    ~ConnectionMessageDisplay()
-        override
-        = default;
+    ~ConnectionMessageDisplay() override
+    {
+        releaseSignalProbes();
+    }
 
     /** Activate the current connection info display overlay, to hide give it a nullptr
      */
@@ -42,11 +43,10 @@ public:
             return;
 
         auto clearSignalDisplayBuffer = [this]() {
-            SignalBlock sample;
-            while (sampleQueue.try_dequeue(sample)) { };
             for (int ch = 0; ch < 8; ch++) {
                 std::fill(lastSamples[ch], lastSamples[ch] + signalBlockSize, 0.0f);
                 cycleLength[ch] = 0.0f;
+                lastSummaries[ch] = {};
             }
         };
 
@@ -60,8 +60,33 @@ public:
             stopTimer(MouseHoverExitDelay);
             if (isSignalDisplay) {
                 clearSignalDisplayBuffer();
-                auto* pd = activeConnection->outobj->cnv->pd;
-                pd->connectionListener = this;
+                releaseSignalProbes();
+                probeProcessor = activeConnection->outobj->cnv->pd;
+
+                // When hovering a selected connection, the other selected signal connections are shown below it
+                Array<Connection*> inspected = { connection };
+                if (connection->isSelected()) {
+                    for (auto* selected : connection->outobj->cnv->getSelectionOfType<Connection>()) {
+                        if (selected != connection && selected->outlet && selected->outlet->isSignal)
+                            inspected.add(selected);
+                    }
+                }
+
+                int numRows = 0;
+                for (auto* inspectedConnection : inspected) {
+                    if (numRows >= SignalProbe::maxChannels)
+                        break;
+
+                    auto probe = std::make_unique<SignalProbe>(inspectedConnection->getPointer(), probeProcessor);
+                    if (!probeProcessor->addSignalProbe(probe.get()))
+                        break;
+
+                    auto const numChannels = std::clamp(inspectedConnection->numSignalChannels, 1, SignalProbe::maxChannels - numRows);
+                    signalProbes.push_back({ std::move(probe), numChannels });
+                    numRows += numChannels;
+                }
+                lastNumChannels = std::max(numRows, 1);
+
                 startTimer(RepaintTimer, 1000 / 5);
                 updateSignalGraph();
             } else {
@@ -77,17 +102,6 @@ public:
         }
     }
 
-    void updateSignalData()
-    {
-        if (!activeConnection)
-            return;
-
-        float output[DEFDACBLKSIZE * 8];
-        if (auto numChannels = activeConnection->getSignalData(output, 8)) {
-            sampleQueue.try_enqueue(SignalBlock(output, numChannels));
-        }
-    }
-
 private:
     void updateTextString(bool isHoverEntered = false)
     {
@@ -155,18 +169,20 @@ private:
 
     void updateSignalGraph()
     {
-        if (activeConnection) {
-            int i = 0;
-            SignalBlock block;
-            while (sampleQueue.try_dequeue(block)) {
-                if (i < numBlocks) {
-                    lastNumChannels = block.numChannels;
-                    for (int ch = 0; ch < block.numChannels; ch++) {
-                        std::copy(block.samples + ch * DEFDACBLKSIZE, block.samples + ch * DEFDACBLKSIZE + DEFDACBLKSIZE, lastSamples[ch] + (i * DEFDACBLKSIZE));
-                    }
-                }
-                i++;
+        if (activeConnection && !signalProbes.empty()) {
+            // Every probe gets as many rows as it has channels, probes that didn't finish a new capture keep their last one
+            int row = 0;
+            for (auto& [probe, numChannels] : signalProbes) {
+                if (row >= SignalProbe::maxChannels)
+                    break;
+
+                auto const numRead = probe->read(lastSamples + row, lastSummaries + row, SignalProbe::maxChannels - row);
+                if (numRead > 0)
+                    numChannels = numRead;
+
+                row += numChannels;
             }
+            lastNumChannels = std::clamp(row, 1, SignalProbe::maxChannels);
 
             auto newBounds = Rectangle<int>(130, jmap<int>(lastNumChannels, 1, 8, 50, 150));
             updateBoundsFromProposed(newBounds);
@@ -174,12 +190,18 @@ private:
         }
     }
 
-    void hideDisplay()
+    void releaseSignalProbes()
     {
-        if (activeConnection) {
-            auto* pd = activeConnection->outobj->cnv->pd;
-            pd->connectionListener = nullptr;
+        for (auto& [probe, numChannels] : signalProbes) {
+            probeProcessor->removeSignalProbe(probe.get());
         }
+        signalProbes.clear();
+        probeProcessor = nullptr;
+    }
+
+    void hideDisplay()
+    {
+        releaseSignalProbes();
         stopTimer(RepaintTimer);
         setVisible(false);
         activeConnection = nullptr;
@@ -255,8 +277,8 @@ private:
 
                 auto channelBounds = internalBounds.removeFromTop(totalHeight / std::max(lastNumChannels, 1)).reduced(5).toFloat();
 
-                auto peakAmplitude = *std::max_element(lastSamples[ch], lastSamples[ch] + signalBlockSize);
-                auto valleyAmplitude = *std::min_element(lastSamples[ch], lastSamples[ch] + signalBlockSize);
+                auto peakAmplitude = lastSummaries[ch].max;
+                auto valleyAmplitude = lastSummaries[ch].min;
 
                 // Audio was empty, draw a line and continue, no need to perform an fft
                 if (approximatelyEqual(peakAmplitude, 0.0f) && approximatelyEqual(valleyAmplitude, 0.0f)) {
@@ -324,7 +346,7 @@ private:
 
                 // Calculate text length
                 auto numbersFont = Fonts::getTabularNumbersFont().withHeight(11.f);
-                auto text = String(lastSamples[ch][rand() % 512], 3);
+                auto text = String(lastSummaries[ch].rms, 3);
                 auto textWidth = numbersFont.getStringWidth(text);
                 auto textBounds = channelBounds.expanded(5).removeFromBottom(18).removeFromRight(textWidth + 8);
 
@@ -377,45 +399,21 @@ private:
 
     Rectangle<int> previousBounds;
 
-    struct SignalBlock {
-        SignalBlock()
-            : numChannels(0)
-        {
-        }
-
-        SignalBlock(float* input, int channels)
-            : numChannels(channels)
-        {
-            std::copy(input, input + (numChannels * DEFDACBLKSIZE), samples);
-        }
-
-        SignalBlock(SignalBlock&& toMove)
-        {
-            numChannels = toMove.numChannels;
-            std::copy(toMove.samples, toMove.samples + (numChannels * DEFDACBLKSIZE), samples);
-        }
-
-        SignalBlock& operator=(SignalBlock&& toMove)
-        {
-            if (&toMove != this) {
-                numChannels = toMove.numChannels;
-                std::copy(toMove.samples, toMove.samples + (numChannels * DEFDACBLKSIZE), samples);
-            }
-            return *this;
-        }
+    Image oscilloscopeImage;
+    static constexpr int signalBlockSize = SignalProbe::captureSize;
 
-        float samples[32 * DEFDACBLKSIZE];
+    struct InspectedSignal {
+        std::unique_ptr<SignalProbe> probe;
         int numChannels;
     };
 
-    Image oscilloscopeImage;
-    static constexpr int signalBlockSize = 1024;
-    static constexpr int numBlocks = 1024 / 64;
-    // 32*64 samples gives us space for 1024 samples across 8 channels
-    moodycamel::ReaderWriterQueue<SignalBlock> sampleQueue = moodycamel::ReaderWriterQueue<SignalBlock>(numBlocks);
+    // The hovered connection, followed by the other selected signal connections, registered while the display is shown
+    std::vector<InspectedSignal> signalProbes;
+    PluginProcessor* probeProcessor = nullptr;
 
     float cycleLength[8] = { 0.0f };
     float lastSamples[8][1024] = { { 0.0f } };
+    SignalProbe::Summary lastSummaries[8];
     int lastNumChannels = 1;
 
     dsp::FFT signalDisplayFFT = dsp::FFT(10);
@@ -32,7 +32,7 @@ public:
     {
         exportingView->showState(ExportingProgressView::Busy);
 
-        StringArray args = { heavyExecutable.getFullPathName(), pdPatch, "-o" + outdir };
+        StringArray args;
 
         name = name.replaceCharacter('-', '_');
         args.add("-n" + name);
@@ -44,31 +44,18 @@ public:
 
         args.add("-v");
 
-        String paths = "-p";
-        for (auto& path : searchPaths) {
-            paths += " " + path;
-        }
-
-        args.add(paths);
-
         if (shouldQuit)
             return true;
 
-        start(args.joinIntoString(" "));
-
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        auto outputFile = File(outdir);
+        auto exitCode = runHeavy(pdPatch, args, searchPaths, outputFile);
 
         if (shouldQuit)
             return true;
 
-        auto outputFile = File(outdir);
         outputFile.getChildFile("ir").deleteRecursively();
         outputFile.getChildFile("hv").deleteRecursively();
 
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
-
-        return getExitCode();
+        return exitCode;
     }
 };
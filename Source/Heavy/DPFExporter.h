@@ -118,7 +118,7 @@ public:
     {
         exportingView->showState(ExportingProgressView::Busy);
 
-        StringArray args = { heavyExecutable.getFullPathName(), pdPatch, "-o" + outdir };
+        StringArray args;
 
         name = name.replaceCharacter('-', '_');
         args.add("-n" + name);
@@ -173,64 +173,60 @@ public:
         args.add("-v");
         args.add("-gdpf");
 
-        String paths = "-p";
-        for (auto& path : searchPaths) {
-            paths += " " + path;
-        }
-
-        args.add(paths);
-
         if (shouldQuit)
             return true;
 
-        start(args.joinIntoString(" "));
+        // When compiling, generate into the build directory from the previous export, so only changed sources get recompiled
+        bool compile = getValue<int>(exportTypeValue) == 2;
+        auto outputFile = File(outdir);
+        auto buildDir = compile ? getBuildDirectory("dpf", name) : outputFile;
 
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        bool generationExitCode = runHeavy(pdPatch, args, searchPaths, buildDir);
 
         if (shouldQuit)
             return true;
 
-        auto outputFile = File(outdir);
-        outputFile.getChildFile("ir").deleteRecursively();
-        outputFile.getChildFile("hv").deleteRecursively();
-        outputFile.getChildFile("c").deleteRecursively();
-
         auto DPF = Toolchain::dir.getChildFile("lib").getChildFile("dpf");
-        DPF.copyDirectoryTo(outputFile.getChildFile("dpf"));
 
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
+        if (!compile) {
+            outputFile.getChildFile("ir").deleteRecursively();
+            outputFile.getChildFile("hv").deleteRecursively();
+            outputFile.getChildFile("c").deleteRecursively();
+            DPF.copyDirectoryTo(outputFile.getChildFile("dpf"));
+        }
 
-        bool generationExitCode = getExitCode();
         // Check if we need to compile
-        if (!generationExitCode && getValue<int>(exportTypeValue) == 2) {
+        if (!generationExitCode && compile) {
+            exportingView->startStage("Compiling");
+
+            syncDirectory(DPF, buildDir.getChildFile("dpf"), false);
+
             auto workingDir = File::getCurrentWorkingDirectory();
 
-            outputFile.setAsCurrentWorkingDirectory();
+            buildDir.setAsCurrentWorkingDirectory();
 
             auto bin = Toolchain::dir.getChildFile("bin");
             auto make = bin.getChildFile("make" + exeSuffix);
-            auto makefile = outputFile.getChildFile("Makefile");
+            auto makefile = buildDir.getChildFile("Makefile");
 
 #if JUCE_MAC
-            Toolchain::startShellScript("make -j4 -f " + makefile.getFullPathName(), this);
+            Toolchain::startShellScript("make -j" + getNumCompileJobs() + " -f " + makefile.getFullPathName(), this);
 #elif JUCE_WINDOWS
             auto path = "export PATH=\"$PATH:" + Toolchain::dir.getChildFile("bin").getFullPathName().replaceCharacter('\\', '/') + "\"\n";
             auto cc = "CC=" + Toolchain::dir.getChildFile("bin").getChildFile("gcc.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
             auto cxx = "CXX=" + Toolchain::dir.getChildFile("bin").getChildFile("g++.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
 
-            Toolchain::startShellScript(path + cc + cxx + make.getFullPathName().replaceCharacter('\\', '/') + " -j4 -f " + makefile.getFullPathName().replaceCharacter('\\', '/'), this);
+            Toolchain::startShellScript(path + cc + cxx + make.getFullPathName().replaceCharacter('\\', '/') + " -j" + getNumCompileJobs() + " -f " + makefile.getFullPathName().replaceCharacter('\\', '/'), this);
 
 #else // Linux or BSD
             auto prepareEnvironmentScript = Toolchain::dir.getChildFile("scripts").getChildFile("anywhere-setup.sh").getFullPathName() + "\n";
 
             auto buildScript = prepareEnvironmentScript
                 + make.getFullPathName()
-                + " -j4 -f " + makefile.getFullPathName();
+                + " -j" + getNumCompileJobs() + " -f " + makefile.getFullPathName();
 
             // For some reason we need to do this again
-            outputFile.getChildFile("dpf").getChildFile("utils").getChildFile("generate-ttl.sh").setExecutePermission(true);
+            buildDir.getChildFile("dpf").getChildFile("utils").getChildFile("generate-ttl.sh").setExecutePermission(true);
             Toolchain::dir.getChildFile("scripts").getChildFile("anywhere-setup.sh").getChildFile("generate-ttl.sh").setExecutePermission(true);
 
             Toolchain::startShellScript(buildScript, this);
@@ -244,38 +240,31 @@ public:
 
             workingDir.setAsCurrentWorkingDirectory();
 
-            // Copy output
+            // Copy output, the build directory keeps its own copy for the next export
+            auto binDir = buildDir.getChildFile("bin");
             if (lv2)
-                outputFile.getChildFile("bin").getChildFile(name + ".lv2").copyDirectoryTo(outputFile.getChildFile(name + ".lv2"));
+                binDir.getChildFile(name + ".lv2").copyDirectoryTo(outputFile.getChildFile(name + ".lv2"));
             if (vst3)
-                outputFile.getChildFile("bin").getChildFile(name + ".vst3").copyDirectoryTo(outputFile.getChildFile(name + ".vst3"));
+                binDir.getChildFile(name + ".vst3").copyDirectoryTo(outputFile.getChildFile(name + ".vst3"));
 #if JUCE_WINDOWS
             if (vst2)
-                outputFile.getChildFile("bin").getChildFile(name + "-vst.dll").moveFileTo(outputFile.getChildFile(name + "-vst.dll"));
+                binDir.getChildFile(name + "-vst.dll").copyFileTo(outputFile.getChildFile(name + "-vst.dll"));
 #elif JUCE_LINUX
             if (vst2)
-                outputFile.getChildFile("bin").getChildFile(name + "-vst.so").moveFileTo(outputFile.getChildFile(name + "-vst.so"));
+                binDir.getChildFile(name + "-vst.so").copyFileTo(outputFile.getChildFile(name + "-vst.so"));
 #elif JUCE_MAC
             if (vst2)
-                outputFile.getChildFile("bin").getChildFile(name + ".vst").copyDirectoryTo(outputFile.getChildFile(name + ".vst"));
+                binDir.getChildFile(name + ".vst").copyDirectoryTo(outputFile.getChildFile(name + ".vst"));
 #endif
             if (clap)
-                outputFile.getChildFile("bin").getChildFile(name + ".clap").moveFileTo(outputFile.getChildFile(name + ".clap"));
-            if (jack)
-                outputFile.getChildFile("bin").getChildFile(name).moveFileTo(outputFile.getChildFile(name));
+                binDir.getChildFile(name + ".clap").copyFileTo(outputFile.getChildFile(name + ".clap"));
+            if (jack) {
+                binDir.getChildFile(name).copyFileTo(outputFile.getChildFile(name));
+                outputFile.getChildFile(name).setExecutePermission(true);
+            }
 
             bool compilationExitCode = getExitCode();
 
-            // Clean up if successful
-            if (!compilationExitCode) {
-                outputFile.getChildFile("dpf").deleteRecursively();
-                outputFile.getChildFile("build").deleteRecursively();
-                outputFile.getChildFile("plugin").deleteRecursively();
-                outputFile.getChildFile("bin").deleteRecursively();
-                outputFile.getChildFile("README.md").deleteFile();
-                outputFile.getChildFile("Makefile").deleteFile();
-            }
-
             return compilationExitCode;
         }
 
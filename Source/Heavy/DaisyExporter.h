@@ -190,7 +190,7 @@ public:
         auto size = getValue<int>(patchSizeValue);
         auto appType = getValue<int>(appTypeValue);
 
-        StringArray args = { heavyExecutable.getFullPathName(), pdPatch, "-o" + outdir };
+        StringArray args;
 
         name = name.replaceCharacter('-', '_');
         args.add("-n" + name);
@@ -263,42 +263,27 @@ public:
         args.add("-v");
         args.add("-gdaisy");
 
-        String paths = "-p";
-        for (auto& path : searchPaths) {
-            paths += " " + path;
-        }
-
-        args.add(paths);
-
-        start(args.joinIntoString(" "));
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        // When compiling, generate into the build directory from the previous export, so only changed sources get recompiled
+        auto outputFile = File(outdir);
+        auto buildDir = compile ? getBuildDirectory("daisy", name) : outputFile;
 
-        exportingView->logToConsole("Compiling for " + board + "...\n");
+        bool heavyExitCode = runHeavy(pdPatch, args, searchPaths, buildDir);
 
         if (shouldQuit)
             return true;
 
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
-
-        auto outputFile = File(outdir);
-        auto sourceDir = outputFile.getChildFile("daisy").getChildFile("source");
-
-        bool heavyExitCode = getExitCode();
+        auto sourceDir = buildDir.getChildFile("daisy").getChildFile("source");
 
         if (compile) {
+            exportingView->startStage("Compiling for " + board);
 
             auto bin = Toolchain::dir.getChildFile("bin");
             auto libDaisy = Toolchain::dir.getChildFile("lib").getChildFile("libdaisy");
             auto make = bin.getChildFile("make" + exeSuffix);
             auto compiler = bin.getChildFile("arm-none-eabi-gcc" + exeSuffix);
 
-            libDaisy.copyDirectoryTo(outputFile.getChildFile("libdaisy"));
-
-            outputFile.getChildFile("ir").deleteRecursively();
-            outputFile.getChildFile("hv").deleteRecursively();
-            outputFile.getChildFile("c").deleteRecursively();
+            // libdaisy's build output lives next to its sources, so it only gets built on the first export
+            syncDirectory(libDaisy, buildDir.getChildFile("libdaisy"), false);
 
             auto workingDir = File::getCurrentWorkingDirectory();
 
@@ -309,7 +294,7 @@ public:
 
 #if JUCE_WINDOWS
             auto buildScript = make.getFullPathName().replaceCharacter('\\', '/')
-                + " -j4 -f "
+                + " -j" + getNumCompileJobs() + " -f "
                 + sourceDir.getChildFile("Makefile").getFullPathName().replaceCharacter('\\', '/')
                 + " GCC_PATH="
                 + gccPath.replaceCharacter('\\', '/')
@@ -318,7 +303,7 @@ public:
             Toolchain::startShellScript(buildScript, this);
 #else
             String buildScript = make.getFullPathName()
-                + " -j4 -f " + sourceDir.getChildFile("Makefile").getFullPathName()
+                + " -j" + getNumCompileJobs() + " -f " + sourceDir.getChildFile("Makefile").getFullPathName()
                 + " GCC_PATH=" + gccPath
                 + " PROJECT_NAME=" + name;
 
@@ -395,7 +380,7 @@ public:
                     }
                 }
 
-                exportingView->logToConsole("Flashing...\n");
+                exportingView->startStage("Flashing");
 
 #if JUCE_WINDOWS
                 String flashScript = "export PATH=\"" + bin.getFullPathName().replaceCharacter('\\', '/') + ":$PATH\"\n"
@@ -424,16 +409,11 @@ public:
                 return heavyExitCode && flashExitCode;
             } else {
                 auto binLocation = outputFile.getChildFile(name + ".bin");
-                sourceDir.getChildFile("build").getChildFile("HeavyDaisy_" + name + ".bin").moveFileTo(binLocation);
+                sourceDir.getChildFile("build").getChildFile("HeavyDaisy_" + name + ".bin").copyFileTo(binLocation);
             }
 
-            outputFile.getChildFile("daisy").deleteRecursively();
-            outputFile.getChildFile("libdaisy").deleteRecursively();
-
             return heavyExitCode && compileExitCode;
         } else {
-            auto outputFile = File(outdir);
-
             auto libDaisy = Toolchain::dir.getChildFile("lib").getChildFile("libdaisy");
             libDaisy.copyDirectoryTo(outputFile.getChildFile("libdaisy"));
 
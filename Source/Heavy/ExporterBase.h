@@ -25,6 +25,10 @@ struct ExporterBase : public Component
 
     inline static File heavyExecutable = Toolchain::dir.getChildFile("bin").getChildFile("Heavy").getChildFile("Heavy" + exeSuffix);
 
+    // Heavy output for every patch and settings combination we exported recently, and the persistent build directories
+    inline static File const cacheDir = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("Heavy");
+    static constexpr int maxCachedExports = 32;
+
     bool validPatchSelected = false;
 
     File patchFile;
@@ -165,6 +169,8 @@ struct ExporterBase : public Component
             if (shouldQuit)
                 return;
 
+            exportingView->logStageTimings();
+
             exportingView->showState(result ? ExportingProgressView::Failure : ExportingProgressView::Success);
 
             exportingView->stopMonitoring();
@@ -216,6 +222,200 @@ struct ExporterBase : public Component
         return metadata.getFullPathName();
     }
 
+    // Runs Heavy, unless the same patch graph was already exported with the same arguments, then the cached output is used
+    // Returns Heavy's exit code
+    int runHeavy(String const& pdPatch, StringArray heavyArgs, StringArray const& searchPaths, File const& outputDir)
+    {
+        exportingView->startStage("Generating code");
+
+        auto const key = getCacheKey(File(pdPatch), heavyArgs, searchPaths);
+        auto const cached = cacheDir.getChildFile("Generated").getChildFile(key);
+
+        if (cached.isDirectory()) {
+            exportingView->logToConsole("Patch and settings are unchanged, using cached code\n");
+            cached.setLastModificationTime(Time::getCurrentTime());
+        } else {
+            // Every export generates into its own directory, so concurrent exports of the same patch can't overwrite each other
+            auto generated = cacheDir.getChildFile("Generated").getChildFile("tmp-" + key + "-" + Uuid().toString().substring(10));
+
+            StringArray args = { heavyExecutable.getFullPathName(), pdPatch, "-o" + generated.getFullPathName() };
+            args.addArray(heavyArgs);
+
+            String paths = "-p";
+            for (auto& path : searchPaths) {
+                paths += " " + path;
+            }
+            args.add(paths);
+
+            start(args.joinIntoString(" "));
+            waitForProcessToFinish(-1);
+            exportingView->flushConsole();
+
+            // Delay to get correct exit code
+            Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
+
+            auto exitCode = static_cast<int>(getExitCode());
+            if (exitCode || shouldQuit) {
+                generated.deleteRecursively();
+                return shouldQuit ? 1 : exitCode;
+            }
+
+            // If another export of the same patch finished first, its output is identical, so use that one
+            if (!generated.moveFileTo(cached)) {
+                generated.deleteRecursively();
+                if (!cached.isDirectory()) {
+                    exportingView->logToConsole("Couldn't store generated code in " + cached.getFullPathName() + "\n");
+                    return 1;
+                }
+            }
+            removeOldCacheEntries();
+        }
+
+        syncDirectory(cached, outputDir, outputDir.isAChildOf(cacheDir));
+        return 0;
+    }
+
+    // Build directory that is kept between exports, so make only needs to recompile what changed
+    static File getBuildDirectory(String const& target, String const& projectName)
+    {
+        auto dir = cacheDir.getChildFile("Builds").getChildFile(target + "_" + projectName);
+        dir.createDirectory();
+        return dir;
+    }
+
+    static String getNumCompileJobs()
+    {
+        return String(std::max(1, SystemStats::getNumCpus()));
+    }
+
+    // Copies the files that are different, so unchanged files keep their modification time
+    // With removeStaleSources, sources that are no longer generated get removed, so make won't try to compile them
+    static void syncDirectory(File const& source, File const& target, bool removeStaleSources)
+    {
+        for (auto const& entry : RangedDirectoryIterator(source, true, "*", File::findFiles)) {
+            auto const& file = entry.getFile();
+            auto destination = target.getChildFile(file.getRelativePathFrom(source));
+            if (!destination.existsAsFile() || destination.getSize() != file.getSize() || !destination.hasIdenticalContentTo(file)) {
+                destination.getParentDirectory().createDirectory();
+                file.copyFileTo(destination);
+            }
+        }
+
+        if (!removeStaleSources)
+            return;
+
+        // Only look inside directories that we generated, the build directory also contains libraries and build output
+        for (auto const& directory : source.findChildFiles(File::findDirectories, false)) {
+            for (auto const& entry : RangedDirectoryIterator(target.getChildFile(directory.getFileName()), true, "*.c;*.cpp;*.h;*.hpp", File::findFiles)) {
+                auto const& file = entry.getFile();
+                if (!source.getChildFile(file.getRelativePathFrom(target)).existsAsFile())
+                    file.deleteFile();
+            }
+        }
+    }
+
 private:
+    // Hash of everything that affects Heavy's output: the patch with all abstractions it uses, the arguments and the Heavy version
+    static String getCacheKey(File const& pdPatch, StringArray const& heavyArgs, StringArray const& searchPaths)
+    {
+        MemoryOutputStream key;
+        key << heavyExecutable.getLastModificationTime().toMilliseconds() << " " << heavyExecutable.getSize() << "\n";
+
+        for (auto const& arg : heavyArgs) {
+            // Metadata is passed as a temporary file, so use its content
+            if (arg.startsWith("-m"))
+                key << File(arg.substring(2)).loadFileAsString();
+            else
+                key << arg;
+            key << "\n";
+        }
+
+        for (auto const& path : searchPaths) {
+            key << path << "\n";
+        }
+
+        StringArray visited;
+        addPatchGraph(key, pdPatch, searchPaths, visited);
+
+        return SHA256(key.getData(), key.getDataSize()).toHexString();
+    }
+
+    // Adds the content of the patch, and of every abstraction it uses that can be found in the search paths
+    // Like Pd, abstractions are looked up next to the patch, then in the paths added with [declare -path] by the patch and
+    // the patches that contain it, and then in the global search paths
+    static void addPatchGraph(MemoryOutputStream& key, File const& patch, StringArray const& searchPaths, StringArray& visited)
+    {
+        if (visited.contains(patch.getFullPathName()))
+            return;
+
+        visited.add(patch.getFullPathName());
+
+        auto const content = patch.loadFileAsString();
+        key << content;
+
+        StringArray tokens;
+        tokens.addTokens(content, " ;,\r\n", "");
+        tokens.removeEmptyStrings();
+
+        StringArray directories = { patch.getParentDirectory().getFullPathName() };
+
+        for (int i = 0; i + 1 < tokens.size(); i++) {
+            if (tokens[i] != "declare")
+                continue;
+
+            for (int j = i + 1; j + 1 < tokens.size() && tokens[j].startsWithChar('-'); j += 2) {
+                if (tokens[j] == "-path") {
+                    // Relative paths are relative to the patch that declares them
+                    directories.addIfNotAlreadyThere(patch.getParentDirectory().getChildFile(tokens[j + 1]).getFullPathName());
+                }
+            }
+        }
+
+        // The declared paths are also searched for abstractions inside the abstractions this patch uses
+        auto inheritedPaths = directories;
+        inheritedPaths.remove(0);
+        inheritedPaths.addArray(searchPaths);
+        directories.addArray(searchPaths);
+
+        for (int i = 0; i + 3 < tokens.size(); i++) {
+            if (tokens[i] != "obj")
+                continue;
+
+            auto const abstraction = tokens[i + 3] + ".pd";
+            for (auto const& directory : directories) {
+                auto file = File(directory).getChildFile(abstraction);
+                if (file.existsAsFile()) {
+                    addPatchGraph(key, file, inheritedPaths, visited);
+                    break;
+                }
+            }
+        }
+    }
+
+    static void removeOldCacheEntries()
+    {
+        auto entries = cacheDir.getChildFile("Generated").findChildFiles(File::findDirectories, false);
+
+        // Leave the code that other exports are still generating alone, unless it was left behind a day ago
+        entries.removeIf([](File const& entry) {
+            if (!entry.getFileName().startsWith("tmp-"))
+                return false;
+            if (entry.getLastModificationTime() < Time::getCurrentTime() - RelativeTime::days(1))
+                entry.deleteRecursively();
+            return true;
+        });
+
+        if (entries.size() <= maxCachedExports)
+            return;
+
+        std::sort(entries.begin(), entries.end(), [](File const& a, File const& b) {
+            return a.getLastModificationTime() > b.getLastModificationTime();
+        });
+
+        for (int i = maxCachedExports; i < entries.size(); i++) {
+            entries.getReference(i).deleteRecursively();
+        }
+    }
+
     virtual bool performExport(String pdPatch, String outdir, String name, String copyright, StringArray searchPaths) = 0;
 };
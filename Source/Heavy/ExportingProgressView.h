@@ -4,6 +4,8 @@
  // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
  */
 
+#include <optional>
+
 #include "Canvas.h"
 #include "Utility/OSUtils.h"
 
@@ -42,6 +44,15 @@ public:
     static constexpr int maxLength = 512;
     char processOutput[maxLength];
 
+    struct Stage {
+        String name;
+        double startTime;
+    };
+
+    // Stages of the current export, only used from the export thread
+    std::vector<std::pair<String, double>> stageTimings;
+    std::optional<Stage> currentStage;
+
     ExportingProgressView()
         : Thread("Console thread")
     {
@@ -108,6 +119,37 @@ public:
         }
     }
 
+    // Ends the previous stage, and logs the start of the next one
+    void startStage(String const& name)
+    {
+        finishStage();
+        currentStage = Stage { name, Time::getMillisecondCounterHiRes() };
+        logToConsole(name + "...\n");
+    }
+
+    void finishStage()
+    {
+        if (currentStage) {
+            stageTimings.emplace_back(currentStage->name, (Time::getMillisecondCounterHiRes() - currentStage->startTime) / 1000.0);
+            currentStage.reset();
+        }
+    }
+
+    void logStageTimings()
+    {
+        finishStage();
+        if (stageTimings.empty())
+            return;
+
+        String timings = "\nTimings:\n";
+        for (auto& [name, seconds] : stageTimings) {
+            timings += "  " + name + ": " + String(seconds, 2) + "s\n";
+        }
+        logToConsole(timings);
+
+        stageTimings.clear();
+    }
+
     void stopMonitoring()
     {
         flushConsole();
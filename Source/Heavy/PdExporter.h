@@ -64,7 +64,7 @@ public:
     {
         exportingView->showState(ExportingProgressView::Busy);
 
-        StringArray args = { heavyExecutable.getFullPathName(), pdPatch, "-o" + outdir };
+        StringArray args;
 
         name = name.replaceCharacter('-', '_');
         args.add("-n" + name);
@@ -77,44 +77,38 @@ public:
         args.add("-v");
         args.add("-gpdext");
 
-        String paths = "-p";
-        for (auto& path : searchPaths) {
-            paths += " " + path;
-        }
-
-        args.add(paths);
-
         if (shouldQuit)
             return true;
 
-        start(args.joinIntoString(" "));
+        // When compiling, generate into the build directory from the previous export, so only changed sources get recompiled
+        bool compile = getValue<int>(exportTypeValue) == 2;
+        auto outputFile = File(outdir);
+        auto buildDir = compile ? getBuildDirectory("pdext", name) : outputFile;
 
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        bool generationExitCode = runHeavy(pdPatch, args, searchPaths, buildDir);
 
         if (shouldQuit)
             return true;
 
-        auto outputFile = File(outdir);
-        outputFile.getChildFile("ir").deleteRecursively();
-        outputFile.getChildFile("hv").deleteRecursively();
-
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
+        if (!compile) {
+            outputFile.getChildFile("ir").deleteRecursively();
+            outputFile.getChildFile("hv").deleteRecursively();
+        }
 
-        bool generationExitCode = getExitCode();
         // Check if we need to compile
-        if (!generationExitCode && getValue<int>(exportTypeValue) == 2) {
+        if (!generationExitCode && compile) {
+            exportingView->startStage("Compiling");
+
             auto workingDir = File::getCurrentWorkingDirectory();
 
-            outputFile.setAsCurrentWorkingDirectory();
+            buildDir.setAsCurrentWorkingDirectory();
 
             auto bin = Toolchain::dir.getChildFile("bin");
             auto make = bin.getChildFile("make" + exeSuffix);
-            auto makefile = outputFile.getChildFile("Makefile");
+            auto makefile = buildDir.getChildFile("Makefile");
 
 #if JUCE_MAC
-            Toolchain::startShellScript("make -j4", this);
+            Toolchain::startShellScript("make -j" + getNumCompileJobs(), this);
 #elif JUCE_WINDOWS
             File pdDll;
             if (ProjectInfo::isStandalone) {
@@ -128,14 +122,14 @@ public:
             auto cxx = "CXX=" + Toolchain::dir.getChildFile("bin").getChildFile("g++.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
             auto pdbindir = "PDBINDIR=" + pdDll.getFullPathName().replaceCharacter('\\', '/') + " ";
 
-            Toolchain::startShellScript(path + cc + cxx + pdbindir + make.getFullPathName().replaceCharacter('\\', '/') + " -j4", this);
+            Toolchain::startShellScript(path + cc + cxx + pdbindir + make.getFullPathName().replaceCharacter('\\', '/') + " -j" + getNumCompileJobs(), this);
 
 #else // Linux or BSD
             auto prepareEnvironmentScript = Toolchain::dir.getChildFile("scripts").getChildFile("anywhere-setup.sh").getFullPathName() + "\n";
 
             auto buildScript = prepareEnvironmentScript
                 + make.getFullPathName()
-                + " -j4";
+                + " -j" + getNumCompileJobs();
 
             Toolchain::startShellScript(buildScript, this);
 #endif
@@ -149,13 +143,15 @@ public:
             workingDir.setAsCurrentWorkingDirectory();
 
 #if JUCE_MAC
-            auto external = outputFile.getChildFile(name + "~.pd_darwin");
+            auto external = buildDir.getChildFile(name + "~.pd_darwin");
 #elif JUCE_WINDOWS
-            auto external = outputFile.getChildFile(name + "~.dll");
+            auto external = buildDir.getChildFile(name + "~.dll");
 #else
-            auto external = outputFile.getChildFile(name + "~.pd_linux");
+            auto external = buildDir.getChildFile(name + "~.pd_linux");
 #endif
 
+            external.copyFileTo(outputFile.getChildFile(external.getFileName()));
+
             if (getValue<bool>(copyToPath)) {
                 exportingView->logToConsole("Copying to Externals folder...\n");
                 auto copy_location = ProjectInfo::appDataDir.getChildFile("Externals").getChildFile(external.getFileName());
@@ -163,12 +159,6 @@ public:
                 copy_location.setExecutePermission(1);
             }
 
-            // Clean up
-            outputFile.getChildFile("c").deleteRecursively();
-            outputFile.getChildFile("pdext").deleteRecursively();
-            outputFile.getChildFile("Makefile").deleteFile();
-            outputFile.getChildFile("Makefile.pdlibbuilder").deleteFile();
-
             bool compilationExitCode = getExitCode();
 
             return compilationExitCode;
@@ -614,7 +614,7 @@ void Object::updateTooltips()
     gui->setTooltip(objectInfo.getProperty("description").toString());
 
     // Check pd library for pddp tooltips, those have priority
-    auto ioletTooltips = cnv->pd->objectLibrary->parseIoletTooltips(objectInfo.getChildWithName("iolets"), gui->getText(), numInputs, numOutputs);
+    auto ioletTooltips = cnv->pd->objectLibrary->parseIoletTooltips(gui->getType(), gui->getText(), numInputs, numOutputs);
 
     // First clear all tooltips, so we can see later if it has already been set or not
     for (auto iolet : iolets) {
@@ -703,6 +703,26 @@ void Object::updateTooltips()
     }
 }
 
+bool Object::updateSyncState()
+{
+    auto newSyncState = std::tuple<Rectangle<int>, int, int>({}, 0, 0);
+    auto& [bounds, numIn, numOut] = newSyncState;
+
+    if (gui)
+        bounds = gui->getPdBounds();
+
+    if (auto* ptr = pd::Interface::checkObject(getPointer())) {
+        numIn = pd::Interface::numInlets(ptr);
+        numOut = pd::Interface::numOutlets(ptr);
+    }
+
+    if (newSyncState == lastSyncState)
+        return false;
+
+    lastSyncState = newSyncState;
+    return true;
+}
+
 void Object::updateIolets()
 {
     if (!getPointer())
@@ -925,6 +945,7 @@ void Object::mouseUp(MouseEvent const& e)
         cnv->patch.endUndoSequence("Drag");
     }
     
+    cnv->pd->patchSearchIndex.invalidate(cnv->patch.getPointer().get());
     cnv->needsSearchUpdate = true;
 }
 
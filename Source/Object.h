@@ -44,6 +44,9 @@ public:
 
     void updateIolets();
 
+    // Returns true if the bounds or iolet count of this object changed on the Pd side since the last canvas synchronisation
+    bool updateSyncState();
+
     void setType(String const& newType, pd::WeakReference existingObject = nullptr);
     void updateBounds();
     void applyBounds();
@@ -141,6 +144,8 @@ private:
 
     std::unique_ptr<TextEditor> newObjectEditor;
 
+    std::tuple<Rectangle<int>, int, int> lastSyncState = { {}, -1, -1 };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Object)
     JUCE_DECLARE_WEAK_REFERENCEABLE(Object)
 };
@@ -4,6 +4,8 @@
  // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
  */
 
+#include <numeric>
+
 #include "Components/PropertiesPanel.h"
 
 extern "C" {
@@ -36,12 +38,13 @@ public:
         , pd(instance)
     {
         vec.reserve(8192);
-        temp.reserve(8192);
+        staging.reserve(8192);
         try {
             read(vec);
         } catch (...) {
             error = true;
         }
+        peaks.invalidateAll();
         
         updateParameters();
         
@@ -76,35 +79,13 @@ public:
         new (&arr) pd::WeakReference(array, pd);
     }
 
-    std::vector<float> rescale(std::vector<float> const& v, unsigned const newSize)
-    {
-        if (v.empty()) {
-            return {};
-        }
-
-        std::vector<float> result(newSize);
-        const std::size_t oldSize = v.size();
-        for (unsigned i = 0; i < newSize; i++) {
-            auto const idx = i * (oldSize - 1) / newSize;
-            auto const mod = i * (oldSize - 1) % newSize;
-
-            if (mod == 0)
-                result[i] = v[idx];
-            else {
-                float const part = float(mod) / float(newSize);
-                result[i] = v[idx] * (1.0 - part) + v[idx + 1] * part;
-            }
-        }
-        return result;
-    }
-
     void paintGraph(Graphics& g)
     {
         auto const h = static_cast<float>(getHeight());
         auto const w = static_cast<float>(getWidth());
-        std::vector<float> points = vec;
+        auto const& points = vec;
 
-        if (!points.empty()) {
+        if (!points.empty() && getWidth() > 0) {
             std::array<float, 2> scale = getScale();
             bool invert = false;
 
@@ -114,9 +95,10 @@ public:
             }
 
             // More than a point per pixel will cause insane loads, and isn't actually helpful
-            // Instead, linearly interpolate the vector to a max size of width in pixels
+            // Instead, draw the range of samples under each pixel
             if (vec.size() >= w) {
-                points = rescale(points, w);
+                paintPeaks(g, scale, invert);
+                return;
             }
 
             float const dh = h / (scale[1] - scale[0]);
@@ -182,7 +164,72 @@ public:
         }
     }
     
-    void receiveMessage(t_symbol* symbol, const pd::Atom atoms[8], int numAtoms) override
+    // Draws the min/max of the samples under each pixel, looked up from the peak pyramid
+    // Polygon draws a line through the min and max of every pixel, Points draws both as points, Curve fills the range in between
+    void paintPeaks(Graphics& g, std::array<float, 2> scale, bool invert)
+    {
+        peaks.update(vec);
+
+        auto const h = static_cast<float>(getHeight());
+        auto const numPixels = static_cast<size_t>(getWidth());
+        auto const numSamples = vec.size();
+        auto const lineWidth = static_cast<float>(getLineWidth());
+        auto const halfLineWidth = lineWidth * 0.5f;
+        auto const drawType = getDrawType();
+        float const dh = h / (scale[1] - scale[0]);
+
+        RectangleList<float> peakRects;
+        peakRects.ensureStorageAllocated(static_cast<int>(drawType == DrawType::Points ? numPixels * 2 : numPixels));
+
+        Path peakPath;
+        peakPath.preallocateSpace(static_cast<int>(numPixels * 6));
+
+        for (size_t x = 0; x < numPixels; x++) {
+            auto const start = x * numSamples / numPixels;
+            // Include the first sample of the next pixel, so neighbouring ranges connect
+            auto const end = std::min(numSamples, (x + 1) * numSamples / numPixels + 1);
+            auto [min, max] = peaks.getRange(vec, start, end);
+
+            float top = h - (std::clamp(max, scale[0], scale[1]) - scale[0]) * dh;
+            float bottom = h - (std::clamp(min, scale[0], scale[1]) - scale[0]) * dh;
+
+            if (invert) {
+                top = h - top;
+                bottom = h - bottom;
+                std::swap(top, bottom);
+            }
+
+            auto const px = static_cast<float>(x);
+            switch (drawType) {
+            case DrawType::Polygon: {
+                if (x == 0)
+                    peakPath.startNewSubPath(px, top);
+                else
+                    peakPath.lineTo(px, top);
+                peakPath.lineTo(px, bottom);
+                break;
+            }
+            case DrawType::Points: {
+                peakRects.addWithoutMerging({ px, top - halfLineWidth, 1.0f, lineWidth });
+                if (bottom - top > lineWidth)
+                    peakRects.addWithoutMerging({ px, bottom - halfLineWidth, 1.0f, lineWidth });
+                break;
+            }
+            default: {
+                peakRects.addWithoutMerging({ px, top - halfLineWidth, 1.0f, bottom - top + lineWidth });
+                break;
+            }
+            }
+        }
+
+        g.setColour(getContentColour());
+        if (drawType == DrawType::Polygon)
+            g.strokePath(peakPath, PathStrokeType(lineWidth));
+        else
+            g.fillRectList(peakRects);
+    }
+
+    void receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch(hash(symbol->s_name)) {
             case hash("edit"): {
@@ -291,6 +338,7 @@ public:
         for (int n = interpStart; n <= interpEnd; n++) {
             vec[n] = jmap<float>(n, interpStart, interpEnd + 1, min, max);
         }
+        peaks.invalidate(interpStart, interpEnd + 1);
 
         // Don't want to touch vec on the other thread, so we copy the vector into the lambda
         auto changed = std::vector<float>(vec.begin() + interpStart, vec.begin() + interpEnd + 1);
@@ -302,9 +350,7 @@ public:
             write(interpStart + n, changed[n]);
         }
 
-        if (auto ptr = arr.get<t_fake_garray>()) {
-            pd->sendDirectMessage(ptr.get(), stringArray);
-        }
+        pd->sendDirectMessage(arr, stringArray);
 
         pd->unlockAudioThread();
         repaint();
@@ -328,6 +374,7 @@ public:
         int currentSize = getArraySize();
         if (vec.size() != currentSize) {
             vec.resize(currentSize);
+            peaks.invalidateAll();
         }
         
         size = currentSize;
@@ -335,14 +382,11 @@ public:
         if (!edited) {
             error = false;
             try {
-                read(temp);
+                if (readChanges())
+                    repaint();
             } catch (...) {
                 error = true;
             }
-            if (temp != vec) {
-                vec.swap(temp);
-                repaint();
-            }
         }
     }
 
@@ -569,6 +613,43 @@ public:
         }
     }
 
+    // Only copies the array while pd is locked, comparing it with vec happens after releasing the lock
+    // The comparison goes per peak bucket, so only the buckets that changed are copied into vec and rebuilt in the peak pyramid
+    // Returns true if anything changed
+    bool readChanges()
+    {
+        {
+            auto ptr = arr.get<t_garray>();
+            if (!ptr)
+                return false;
+
+            auto const size = static_cast<size_t>(garray_getarray(ptr.get())->a_n);
+            staging.resize(size);
+
+            t_word const* words = ((t_word*)garray_vec(ptr.get()));
+            for (size_t i = 0; i < size; i++)
+                staging[i] = words[i].w_float;
+        }
+
+        if (vec.size() != staging.size()) {
+            vec = staging;
+            peaks.invalidateAll();
+            return true;
+        }
+
+        bool changed = false;
+        for (size_t start = 0; start < vec.size(); start += PeakPyramid::bucketSize) {
+            auto const length = std::min(PeakPyramid::bucketSize, vec.size() - start);
+            if (std::memcmp(staging.data() + start, vec.data() + start, length * sizeof(float)) != 0) {
+                std::copy(staging.begin() + start, staging.begin() + start + length, vec.begin() + start);
+                peaks.invalidate(start, start + length);
+                changed = true;
+            }
+        }
+
+        return changed;
+    }
+
     // Writes a value to the array.
     void write(const size_t pos, float const input)
     {
@@ -580,8 +661,110 @@ public:
 
     pd::WeakReference arr;
 
+    // Min/max pyramid over vec, so painting large arrays only costs a few lookups per pixel
+    // The first level holds a min/max pair for every bucketSize samples, each next level halves the resolution
+    struct PeakPyramid {
+        static constexpr size_t bucketSize = 32;
+
+        void invalidate(size_t start, size_t end)
+        {
+            if (allDirty)
+                return;
+
+            for (auto bucket = start / bucketSize; bucket < (end + bucketSize - 1) / bucketSize; bucket++) {
+                dirtyBuckets.push_back(bucket);
+            }
+        }
+
+        void invalidateAll()
+        {
+            allDirty = true;
+            dirtyBuckets.clear();
+        }
+
+        // Recalculates the buckets that were invalidated, and the buckets above them in the coarser levels
+        void update(std::vector<float> const& samples)
+        {
+            if (!allDirty && dirtyBuckets.empty())
+                return;
+
+            auto const numBuckets = (samples.size() + bucketSize - 1) / bucketSize;
+            if (levels.empty() || levels[0].size() != numBuckets) {
+                levels.clear();
+                for (auto levelSize = numBuckets; levelSize > 0; levelSize = levelSize == 1 ? 0 : (levelSize + 1) / 2) {
+                    levels.emplace_back(levelSize);
+                }
+                allDirty = true;
+            }
+
+            if (allDirty) {
+                dirtyBuckets.resize(numBuckets);
+                std::iota(dirtyBuckets.begin(), dirtyBuckets.end(), 0);
+            } else {
+                std::sort(dirtyBuckets.begin(), dirtyBuckets.end());
+                dirtyBuckets.erase(std::unique(dirtyBuckets.begin(), dirtyBuckets.end()), dirtyBuckets.end());
+                dirtyBuckets.erase(std::lower_bound(dirtyBuckets.begin(), dirtyBuckets.end(), numBuckets), dirtyBuckets.end());
+            }
+
+            for (auto const i : dirtyBuckets) {
+                auto const bucketStart = samples.begin() + i * bucketSize;
+                auto const bucketEnd = samples.begin() + std::min((i + 1) * bucketSize, samples.size());
+                auto const [minIt, maxIt] = std::minmax_element(bucketStart, bucketEnd);
+                levels[0][i] = { *minIt, *maxIt };
+            }
+
+            for (size_t level = 1; level < levels.size(); level++) {
+                // The list stays sorted, so halving the indices only leaves neighbouring duplicates
+                for (auto& i : dirtyBuckets)
+                    i /= 2;
+                dirtyBuckets.erase(std::unique(dirtyBuckets.begin(), dirtyBuckets.end()), dirtyBuckets.end());
+
+                auto const& below = levels[level - 1];
+                auto& current = levels[level];
+                for (auto const i : dirtyBuckets) {
+                    auto const& a = below[i * 2];
+                    auto const& b = i * 2 + 1 < below.size() ? below[i * 2 + 1] : a;
+                    current[i] = { std::min(a.first, b.first), std::max(a.second, b.second) };
+                }
+            }
+
+            dirtyBuckets.clear();
+            allDirty = false;
+        }
+
+        // Gets the min/max of the samples in [start, end), rounded outwards to the nearest buckets
+        std::pair<float, float> getRange(std::vector<float> const& samples, size_t start, size_t end) const
+        {
+            if (end - start < bucketSize || levels.empty()) {
+                auto const [minIt, maxIt] = std::minmax_element(samples.begin() + start, samples.begin() + end);
+                return { *minIt, *maxIt };
+            }
+
+            // Use the coarsest level that still has buckets smaller than the range
+            size_t level = 0;
+            size_t levelBucketSize = bucketSize;
+            while (level + 1 < levels.size() && levelBucketSize * 2 <= end - start) {
+                level++;
+                levelBucketSize *= 2;
+            }
+
+            auto const& buckets = levels[level];
+            auto result = std::pair<float, float>(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+            for (auto i = start / levelBucketSize; i <= (end - 1) / levelBucketSize && i < buckets.size(); i++) {
+                result.first = std::min(result.first, buckets[i].first);
+                result.second = std::max(result.second, buckets[i].second);
+            }
+            return result;
+        }
+
+        std::vector<std::vector<std::pair<float, float>>> levels;
+        std::vector<size_t> dirtyBuckets;
+        bool allDirty = true;
+    };
+
     std::vector<float> vec;
-    std::vector<float> temp;
+    std::vector<float> staging;
+    PeakPyramid peaks;
     std::atomic<bool> edited;
     bool error = false;
     const String stringArray = "array";
@@ -934,12 +1117,13 @@ public:
 
     void updateGraphs()
     {
-        if (!pd->tryLockAudioThread())
-            return;
-
         for (auto* graph : graphs) {
             graph->update();
         }
+
+        if (!pd->tryLockAudioThread())
+            return;
+
         for (auto* list : lists) {
             list->update();
         }
@@ -1068,14 +1252,10 @@ public:
     
     void updateGraphs()
     {
-        pd->lockAudioThread();
-
+        // Each graph only locks pd while it copies its array
         for (auto* graph : graphs) {
-            // Update values
             graph->update();
         }
-
-        pd->unlockAudioThread();
     }
 
     void updateLabel() override
@@ -1245,7 +1425,7 @@ public:
         };
     }
 
-    void receiveObjectMessage(hash32 symbol, const pd::Atom atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch(symbol)
         {
@@ -1332,7 +1512,7 @@ public:
         }
     }
     
-    void receiveObjectMessage(hash32 symbol, const pd::Atom atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
     }
     
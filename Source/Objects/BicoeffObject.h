@@ -516,8 +516,7 @@ public:
         addAndMakeVisible(graph);
 
         graph.graphChangeCallback = [this](float a1, float a2, float b0, float b1, float b2) {
-            if (auto obj = ptr.get<void>())
-                pd->sendDirectMessage(obj.get(), "biquad", { a1, a2, b0, b1, b2 });
+            pd->sendDirectMessage(ptr, "biquad", { a1, a2, b0, b1, b2 });
         };
 
         objectParameters.addParamSize(&sizeProperty);
@@ -574,7 +573,7 @@ public:
                 if (!patch)
                     return;
 
-                pd->sendDirectMessage(gobj.get(), "dim", { (float)width, (float)height });
+                pd->sendDirectMessage(ptr, "dim", { (float)width, (float)height });
             }
 
             object->updateBounds();
@@ -604,13 +603,13 @@ public:
                 return;
 
             pd::Interface::moveObject(patch, gobj.get(), b.getX(), b.getY());
-            pd->sendDirectMessage(gobj.get(), "dim", { (float)b.getWidth() - 1, (float)b.getHeight() - 1 });
+            pd->sendDirectMessage(ptr, "dim", { (float)b.getWidth() - 1, (float)b.getHeight() - 1 });
         }
 
         graph.saveProperties();
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("allpass"): {
@@ -178,7 +178,7 @@ public:
         }
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("bgcolor"): {
@@ -48,7 +48,7 @@ public:
         iemHelper.updateLabel(label);
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         iemHelper.receiveObjectMessage(symbol, atoms, numAtoms);
     }
@@ -116,7 +116,7 @@ public:
         cnv->editor->addTab(newCanvas);
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("vis"): {
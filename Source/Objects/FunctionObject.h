@@ -385,12 +385,10 @@ public:
                 repaint();
             } else if (v.refersToSameSourceAs(sendSymbol)) {
                 auto symbol = sendSymbol.toString();
-                if (auto obj = ptr.get<void>())
-                    pd->sendDirectMessage(obj.get(), "send", { pd->generateSymbol(symbol) });
+                pd->sendDirectMessage(ptr, "send", { pd->generateSymbol(symbol) });
             } else if (v.refersToSameSourceAs(receiveSymbol)) {
                 auto symbol = receiveSymbol.toString();
-                if (auto obj = ptr.get<void>())
-                    pd->sendDirectMessage(obj.get(), "receive", { pd->generateSymbol(symbol) });
+                pd->sendDirectMessage(ptr, "receive", { pd->generateSymbol(symbol) });
 
             } else if (v.refersToSameSourceAs(range)) {
                 setRange(getRange());
@@ -406,7 +404,7 @@ public:
         return { hex[0], hex[1], hex[2] };
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("send"): {
@@ -376,16 +376,13 @@ public:
             updateAspectRatio();
         } else if (value.refersToSameSourceAs(sendSymbol)) {
             auto symbol = sendSymbol.toString();
-            if (auto obj = ptr.get<void>())
-                pd->sendDirectMessage(obj.get(), "send", { pd->generateSymbol(symbol) });
+            pd->sendDirectMessage(ptr, "send", { pd->generateSymbol(symbol) });
         } else if (value.refersToSameSourceAs(receiveSymbol)) {
             auto symbol = receiveSymbol.toString();
-            if (auto obj = ptr.get<void>())
-                pd->sendDirectMessage(obj.get(), "receive", { pd->generateSymbol(symbol) });
+            pd->sendDirectMessage(ptr, "receive", { pd->generateSymbol(symbol) });
         } else if (value.refersToSameSourceAs(toggleMode)) {
             auto toggle = getValue<int>(toggleMode);
-            if (auto obj = ptr.get<void>())
-                pd->sendDirectMessage(obj.get(), "toggle", { (float)toggle });
+            pd->sendDirectMessage(ptr, "toggle", { (float)toggle });
             keyboard.setToggleMode(toggle);
         }
     }
@@ -415,7 +412,7 @@ public:
         keyboard.repaint();
     }
 
-    void notesOn(pd::Atom const atoms[8], int numAtoms, bool isOn)
+    void notesOn(pd::Atom const* atoms, int numAtoms, bool isOn)
     {
         for (int at = 0; at < numAtoms; at++) {
             if (isOn)
@@ -426,7 +423,7 @@ public:
         keyboard.repaint();
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         auto elseKeyboard = ptr.get<t_fake_keyboard>();
 
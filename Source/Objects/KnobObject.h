@@ -329,7 +329,7 @@ public:
         knob.setRange(0.0, 1.0, increment);
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("float"):
@@ -511,16 +511,12 @@ public:
 
     void setSendSymbol(String const& symbol) const
     {
-        if (auto knob = ptr.get<void>()) {
-            pd->sendDirectMessage(knob.get(), "send", { pd::Atom(pd->generateSymbol(symbol)) });
-        }
+        pd->sendDirectMessage(ptr, "send", { pd::Atom(pd->generateSymbol(symbol)) });
     }
 
     void setReceiveSymbol(String const& symbol) const
     {
-        if (auto knob = ptr.get<void>()) {
-            pd->sendDirectMessage(knob.get(), "receive", { pd::Atom(pd->generateSymbol(symbol)) });
-        }
+        pd->sendDirectMessage(ptr, "receive", { pd::Atom(pd->generateSymbol(symbol)) });
     }
 
     Colour getBackgroundColour() const
@@ -564,7 +560,7 @@ public:
 
     float getValue()
     {
-        if (auto knb = ptr.get<t_fake_knob>()) {
+        if (auto knb = ptr.peek<t_fake_knob>()) {
             return knb->x_pos;
         }
 
@@ -728,14 +724,15 @@ public:
             updateRange();
         } else if (value.refersToSameSourceAs(angularRange)) {
             auto range = limitValueRange(angularRange, 0, 360);
+            // Delivered right away inside the lock, so updateRotaryParameters reads the new angles
             if (auto knb = ptr.get<t_fake_knob>()) {
-                pd->sendDirectMessage(knb.get(), "angle", { pd::Atom(range) });
+                pd->sendDirectMessage(ptr, "angle", { pd::Atom(range) });
             }
             updateRotaryParameters();
         } else if (value.refersToSameSourceAs(angularOffset)) {
             auto offset = limitValueRange(angularOffset, -180, 180);
             if (auto knb = ptr.get<t_fake_knob>()) {
-                pd->sendDirectMessage(knb.get(), "offset", { pd::Atom(offset) });
+                pd->sendDirectMessage(ptr, "offset", { pd::Atom(offset) });
             }
             updateRotaryParameters();
         } else if (value.refersToSameSourceAs(showArc)) {
@@ -240,8 +240,7 @@ public:
 
     void setList(std::vector<pd::Atom> value)
     {
-        if (auto gatom = ptr.get<t_fake_gatom>())
-            cnv->pd->sendDirectMessage(gatom.get(), std::move(value));
+        cnv->pd->sendDirectMessage(ptr, std::move(value));
     }
 
     void mouseUp(MouseEvent const& e) override
@@ -252,7 +251,7 @@ public:
         }
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("float"):
@@ -458,7 +458,7 @@ public:
         reinterpret_cast<LuaObject*>(target)->receiveLuaPaintMessage(sym, argc, argv);
     }
     
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         if(symbol == hash("open_textfile") && numAtoms >= 1)
         {
@@ -526,7 +526,7 @@ public:
         }
     }
     
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         if(symbol == hash("open_textfile") && numAtoms >= 1)
         {
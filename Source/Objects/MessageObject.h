@@ -200,7 +200,7 @@ public:
         g.drawRoundedRectangle(reducedBounds, Corners::objectCornerRadius, 1.0f);
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         String v = getSymbol();
 
@@ -302,9 +302,7 @@ public:
 
     void click()
     {
-        if (auto message = ptr.get<void>()) {
-            cnv->pd->sendDirectMessage(message.get(), 0);
-        }
+        cnv->pd->sendDirectMessage(ptr, 0);
     }
 
     void mouseUp(MouseEvent const& e) override
@@ -367,9 +367,7 @@ public:
             repaint();
         } else if (v.refersToSameSourceAs(receiveSymbol)) {
             auto receive = receiveSymbol.toString();
-            if (auto note = ptr.get<t_fake_note>()) {
-                pd->sendDirectMessage(note.get(), "receive", { pd->generateSymbol(receive) });
-            }
+            pd->sendDirectMessage(ptr, "receive", { pd->generateSymbol(receive) });
         } else if (v.refersToSameSourceAs(justification)) {
             auto justificationType = getValue<int>(justification);
             if (auto note = ptr.get<t_fake_note>())
@@ -416,7 +414,7 @@ public:
         object->updateBounds();
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("font"): {
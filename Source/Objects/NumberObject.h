@@ -185,7 +185,7 @@ public:
         repaint();
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("float"):
@@ -309,17 +309,29 @@ public:
 
     float getValue()
     {
-        return (ptr.get<t_my_numbox>())->x_val;
+        if (auto nbx = ptr.peek<t_my_numbox>()) {
+            return nbx->x_val;
+        }
+
+        return 0.0f;
     }
 
     float getMinimum()
     {
-        return (ptr.get<t_my_numbox>())->x_min;
+        if (auto nbx = ptr.peek<t_my_numbox>()) {
+            return nbx->x_min;
+        }
+
+        return 0.0f;
     }
 
     float getMaximum()
     {
-        return (ptr.get<t_my_numbox>())->x_max;
+        if (auto nbx = ptr.peek<t_my_numbox>()) {
+            return nbx->x_max;
+        }
+
+        return 0.0f;
     }
 
     void setMinimum(float value)
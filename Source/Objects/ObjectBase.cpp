@@ -452,13 +452,9 @@ void ObjectBase::stopEdition()
 
 void ObjectBase::sendFloatValue(float newValue)
 {
-    t_atom atom;
-    SETFLOAT(&atom, newValue);
-
-    if (auto obj = ptr.get<t_pd>()) {
-        pd_typedmess(obj.get(), cnv->patch.instance->generateSymbol("set"), 1, &atom);
-        pd_bang(obj.get());
-    }
+    // Both are queued, so they arrive together at the start of the next Pd block
+    pd->sendDirectMessage(ptr, "set", { newValue });
+    pd->sendDirectMessage(ptr, "bang", std::vector<pd::Atom> {});
 }
 
 ObjectBase* ObjectBase::createGui(pd::WeakReference ptr, Object* parent)
@@ -640,9 +636,7 @@ bool ObjectBase::canOpenFromMenu()
 
 void ObjectBase::openFromMenu()
 {
-    if (auto obj = ptr.get<t_pd>()) {
-        pd->sendDirectMessage(obj.get(), "menu-open", {});
-    }
+    pd->sendDirectMessage(ptr, "menu-open", {});
 }
 
 bool ObjectBase::hideInGraph()
@@ -685,7 +679,7 @@ bool ObjectBase::canReceiveMouseEvent(int x, int y)
     return true;
 }
 
-void ObjectBase::receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms)
+void ObjectBase::receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms)
 {
     object->triggerOverlayActiveState();
 
@@ -22,7 +22,7 @@ public:
         closeOpenedSubpatchers();
     }
 
-    void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms) override
     {
         if (pd->isPerformingGlobalSync)
             return;
@@ -108,8 +108,7 @@ public:
         if (type == Key) {
             t_symbol* dummy;
             parseKey(keyCode, dummy);
-            if (auto obj = ptr.get<t_pd>())
-                pd->sendDirectMessage(obj.get(), keyCode);
+            pd->sendDirectMessage(ptr, keyCode);
         } else if (type == KeyName) {
 
             String keyString = key.getTextDescription().fromLastOccurrenceOf(" ", false, false);
@@ -124,8 +123,7 @@ public:
             t_symbol* keysym = pd->generateSymbol(keyString);
             parseKey(keyCode, keysym);
 
-            if (auto obj = ptr.get<t_pd>())
-                pd->sendDirectMessage(obj.get(), { 1.0f, keysym });
+            pd->sendDirectMessage(ptr, { 1.0f, keysym });
         }
 
         // Never claim the keypress
@@ -186,8 +184,7 @@ public:
                     if (type == KeyUp) {
                         t_symbol* dummy;
                         parseKey(keyCode, dummy);
-                        if (auto obj = ptr.get<t_pd>())
-                            pd->sendDirectMessage(obj.get(), keyCode);
+                        pd->sendDirectMessage(ptr, keyCode);
                     } else if (type == KeyName) {
 
                         String keyString = key.getTextDescription().fromLastOccurrenceOf(" ", false, false);
@@ -201,8 +198,7 @@ public:
 
                         t_symbol* keysym = pd->generateSymbol(keyString);
                         parseKey(keyCode, keysym);
-                        if (auto obj = ptr.get<t_pd>())
-                            pd->sendDirectMessage(obj.get(), { 0.0f, keysym });
+                        pd->sendDirectMessage(ptr, { 0.0f, keysym });
                     }
 
                     keyPressTimes.remove(n);
@@ -458,7 +454,7 @@ public:
         mouseMove(e);
     }
 
-    void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms) override
     {
         if (!cnv || pd->isPerformingGlobalSync)
             return;
@@ -603,32 +599,24 @@ public:
         if (lastPosition != mouseSource.getScreenPosition()) {
 
             auto pos = mouseSource.getScreenPosition();
-            if (auto obj = ptr.get<void>()) {
-                pd->sendDirectMessage(obj.get(), "_getscreen", { pos.x, pos.y });
-            }
+            pd->sendDirectMessage(ptr, "_getscreen", { pos.x, pos.y });
 
             lastPosition = pos;
         }
         if (mouseSource.isDragging()) {
             if (!isDown) {
-                if (auto obj = ptr.get<void>()) {
-                    pd->sendDirectMessage(obj.get(), "_up", { 0.0f });
-                }
+                pd->sendDirectMessage(ptr, "_up", { 0.0f });
             }
             isDown = true;
             lastMouseDownTime = mouseSource.getLastMouseDownTime();
         } else if (mouseSource.getLastMouseDownTime() > lastMouseDownTime) {
             if (!isDown) {
-                if (auto obj = ptr.get<void>()) {
-                    pd->sendDirectMessage(obj.get(), "_up", { 0.0f });
-                }
+                pd->sendDirectMessage(ptr, "_up", { 0.0f });
             }
             isDown = true;
             lastMouseDownTime = mouseSource.getLastMouseDownTime();
         } else if (isDown) {
-            if (auto obj = ptr.get<void>()) {
-                pd->sendDirectMessage(obj.get(), "_up", { 1.0f });
-            }
+            pd->sendDirectMessage(ptr, "_up", { 1.0f });
             isDown = false;
         }
     }
@@ -674,7 +662,7 @@ public:
         pd->unregisterMessageListener(ptr.getRawUnchecked<void>(), this);
     }
 
-    void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms) override
     {
         if (pd->isPerformingGlobalSync)
             return;
@@ -204,9 +204,7 @@ public:
         if (!getValue<bool>(object->locked) && !getValue<bool>(object->commandLocked))
             return;
 
-        if (auto openfile = ptr.get<void>()) {
-            pd->sendDirectMessage(openfile.get(), "bang", std::vector<pd::Atom> {});
-        }
+        pd->sendDirectMessage(ptr, "bang", std::vector<pd::Atom> {});
     }
 
     void paintOverChildren(Graphics& g) override
@@ -54,7 +54,7 @@ public:
 
                     pdTilde->x_pddir = gensym(pdPath.toRawUTF8());
                     pdTilde->x_schedlibdir = gensym(schedPath.toRawUTF8());
-                    pd->sendDirectMessage(pdTilde.get(), "pd~", { pd->generateSymbol("start") });
+                    pd->sendDirectMessage(ptr, "pd~", { pd->generateSymbol("start") });
                 }
             },
                 true, true, "", "LastPdLocation");
@@ -65,7 +65,7 @@ public:
 
                 pdTilde->x_pddir = gensym(pdPath.toRawUTF8());
                 pdTilde->x_schedlibdir = gensym(schedPath.toRawUTF8());
-                pd->sendDirectMessage(pdTilde.get(), "pd~", { pd->generateSymbol("start") });
+                pd->sendDirectMessage(ptr, "pd~", { pd->generateSymbol("start") });
             }
         }
     }
@@ -98,7 +98,7 @@ public:
         repaint();
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
 
         switch (symbol) {
@@ -166,12 +166,10 @@ public:
                 pic->x_size = getValue<int>(reportSize);
         } else if (value.refersToSameSourceAs(sendSymbol)) {
             auto symbol = sendSymbol.toString();
-            if (auto pic = ptr.get<t_pd>())
-                pd->sendDirectMessage(pic.get(), "send", { pd->generateSymbol(symbol) });
+            pd->sendDirectMessage(ptr, "send", { pd->generateSymbol(symbol) });
         } else if (value.refersToSameSourceAs(receiveSymbol)) {
             auto symbol = receiveSymbol.toString();
-            if (auto pic = ptr.get<t_pd>())
-                pd->sendDirectMessage(pic.get(), "receive", { pd->generateSymbol(symbol) });
+            pd->sendDirectMessage(ptr, "receive", { pd->generateSymbol(symbol) });
         }
     }
 
@@ -59,7 +59,7 @@ public:
         pd->unregisterMessageListener(scalar.getRawUnchecked<void>(), this);
     }
 
-    void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms)
+    void receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms)
     {
         if (hash(symbol->s_name) == hash("redraw")) {
             triggerAsyncUpdate();
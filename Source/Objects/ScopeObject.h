@@ -167,6 +167,7 @@ public:
         if (object->iolets.size() == 3)
             object->iolets[2]->setVisible(false);
 
+        // A bufsize message reallocates the buffers, so we need the pd lock to read them
         if (auto scope = ptr.get<S>()) {
             bufsize = scope->x_bufsize;
             min = scope->x_min;
@@ -275,12 +276,11 @@ public:
                 scope->x_triglevel = getValue<int>(triggerValue);
         } else if (v.refersToSameSourceAs(receiveSymbol)) {
             auto symbol = receiveSymbol.toString();
-            if (auto scope = ptr.get<void>())
-                pd->sendDirectMessage(scope.get(), "receive", { pd->generateSymbol(symbol) });
+            pd->sendDirectMessage(ptr, "receive", { pd->generateSymbol(symbol) });
         }
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("receive"): {
@@ -96,9 +96,7 @@ public:
 
     void setSymbol(String const& value)
     {
-        if (auto gatom = ptr.get<t_fake_gatom>()) {
-            cnv->pd->sendDirectMessage(gatom.get(), value.toStdString());
-        }
+        cnv->pd->sendDirectMessage(ptr, value.toStdString());
     }
 
     String getSymbol()
@@ -207,7 +205,7 @@ public:
         return false;
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
 
@@ -92,7 +92,11 @@ public:
 
     void paint(Graphics& g) override
     {
-        auto values = std::vector<float> { ptr.getRaw<t_vu>()->x_fp, ptr.getRaw<t_vu>()->x_fr };
+        float values[2] = { 0.0f, 0.0f };
+        if (auto vu = ptr.peek<t_vu>()) {
+            values[0] = vu->x_fp;
+            values[1] = vu->x_fr;
+        }
 
         int height = getHeight();
         int width = getWidth();
@@ -157,7 +161,7 @@ public:
         g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
     }
 
-    void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
+    void receiveObjectMessage(hash32 symbol, pd::Atom const* atoms, int numAtoms) override
     {
         switch (symbol) {
         case hash("float"): {
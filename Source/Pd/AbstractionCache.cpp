@@ -0,0 +1,206 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_core/juce_core.h>
+
+using namespace juce;
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+
+extern "C" {
+#include <m_pd.h>
+#include <m_imp.h>
+#include <g_canvas.h>
+#include <z_libpd.h>
+
+void glob_setfilename(void* dummy, t_symbol* name, t_symbol* dir);
+int pd_setloadingabstraction(t_symbol* sym);
+}
+
+#include "AbstractionCache.h"
+
+namespace pd {
+
+struct CachedFile {
+    int64 modificationTime;
+    MemoryBlock content;
+};
+
+struct ParsedFile {
+    int64 modificationTime;
+    t_binbuf* binbuf;
+};
+
+static std::mutex cacheLock;
+static std::map<String, CachedFile> cachedFiles;
+static std::map<std::pair<void*, String>, ParsedFile> parsedFiles;
+
+static constexpr int64 outdated = std::numeric_limits<int64>::min();
+
+// Same as binbuf_evalfile, but reads the file through the cache
+static void evaluateAbstraction(t_symbol* name, t_symbol* dir)
+{
+    auto* b = binbuf_new();
+    auto const dspState = canvas_suspend_dsp();
+    glob_setfilename(nullptr, name, dir);
+
+    if (AbstractionCache::read(b, name->s_name, dir->s_name, 0)) {
+        pd_error(nullptr, "%s: read failed; %s", name->s_name, strerror(errno));
+    } else {
+        // Save the bindings of #N and #A, and restore them afterwards
+        auto* boundA = gensym("#A")->s_thing;
+        auto* boundN = s__N.s_thing;
+        gensym("#A")->s_thing = nullptr;
+        s__N.s_thing = &pd_canvasmaker;
+
+        binbuf_eval(b, nullptr, 0, nullptr);
+
+        gensym("#A")->s_thing = boundA;
+        s__N.s_thing = boundN;
+    }
+
+    glob_setfilename(nullptr, &s_, &s_);
+    binbuf_free(b);
+    canvas_resume_dsp(dspState);
+}
+
+// Same as do_create_abstraction in pd, which creates every instance of an abstraction once it's been found
+static void* createAbstraction(t_symbol* s, int argc, t_atom* argv)
+{
+    char dirbuf[MAXPDSTRING], *nameptr;
+    auto* canvas = glist_getcanvas(canvas_getcurrent());
+    auto* was = s__X.s_thing;
+
+    auto const fd = canvas_open(canvas, s->s_name, ".pd", dirbuf, &nameptr, MAXPDSTRING, 0);
+    if (fd < 0)
+        return nullptr;
+
+    sys_close(fd);
+
+    if (pd_setloadingabstraction(s)) {
+        pd_error(nullptr, "%s: can't load abstraction within itself", s->s_name);
+        return nullptr;
+    }
+
+    t_pd* x = nullptr;
+    canvas_setargs(argc, argv);
+    evaluateAbstraction(gensym(nameptr), gensym(dirbuf));
+
+    if (s__X.s_thing && was != s__X.s_thing)
+        x = s__X.s_thing;
+
+    if (x)
+        canvas_popabstraction(reinterpret_cast<t_canvas*>(x));
+    else
+        s__X.s_thing = was;
+
+    canvas_setargs(0, nullptr);
+    return x;
+}
+
+// Registered after the loaders for externals and pdlua, so it comes in the same place as pd's own abstraction lookup
+// Pd only tries its own lookup when no loader has found anything in a search path, so every .pd abstraction now goes through here
+static int abstractionLoader(t_canvas* canvas, char const* classname, char const* path)
+{
+    if (!path || !*path)
+        return 0;
+
+    auto const dir = File(String::fromUTF8(path));
+    if (!dir.getChildFile(String::fromUTF8(classname) + ".pd").existsAsFile())
+        return 0;
+
+    class_set_extern_dir(gensym(path));
+    auto* c = class_new(gensym(classname), reinterpret_cast<t_newmethod>(createAbstraction), nullptr, 0, 0, A_GIMME, 0);
+    class_set_extern_dir(&s_);
+
+    return c != nullptr;
+}
+
+void AbstractionCache::initialise()
+{
+    sys_register_loader(abstractionLoader);
+}
+
+int AbstractionCache::read(t_binbuf* b, char const* filename, char const* dirname, int crflag)
+{
+    // Max patches need to be converted, and are rarely used as abstractions, so don't cache those
+    if (crflag)
+        return binbuf_read(b, filename, dirname, crflag);
+
+    auto file = File(String::fromUTF8(dirname)).getChildFile(String::fromUTF8(filename));
+    auto const path = file.getFullPathName();
+    auto const modificationTime = file.getLastModificationTime().toMilliseconds();
+    auto* instance = static_cast<void*>(libpd_this_instance());
+
+    std::lock_guard<std::mutex> lock(cacheLock);
+
+    auto parsed = parsedFiles.find({ instance, path });
+    if (parsed == parsedFiles.end() || parsed->second.modificationTime != modificationTime) {
+        auto cached = cachedFiles.find(path);
+        if (cached == cachedFiles.end() || cached->second.modificationTime != modificationTime) {
+            MemoryBlock content;
+            if (!file.loadFileAsData(content))
+                return binbuf_read(b, filename, dirname, crflag); // Let pd report the error
+
+            cached = cachedFiles.insert_or_assign(path, CachedFile { modificationTime, std::move(content) }).first;
+        }
+
+        if (parsed == parsedFiles.end())
+            parsed = parsedFiles.emplace(std::make_pair(instance, path), ParsedFile { modificationTime, binbuf_new() }).first;
+
+        auto const& content = cached->second.content;
+        binbuf_text(parsed->second.binbuf, static_cast<char const*>(content.getData()), content.getSize());
+        parsed->second.modificationTime = modificationTime;
+    }
+
+    auto* cachedBinbuf = parsed->second.binbuf;
+    binbuf_clear(b);
+    binbuf_add(b, binbuf_getnatom(cachedBinbuf), binbuf_getvec(cachedBinbuf));
+    return 0;
+}
+
+// Pd might be reading from a parsed binbuf on another thread, so we only mark them as outdated here
+// The next read on the pd thread parses the file again into the same binbuf
+void AbstractionCache::invalidate(String const& path)
+{
+    std::lock_guard<std::mutex> lock(cacheLock);
+
+    cachedFiles.erase(path);
+    for (auto& [key, parsed] : parsedFiles) {
+        if (key.second == path)
+            parsed.modificationTime = outdated;
+    }
+}
+
+void AbstractionCache::clear()
+{
+    std::lock_guard<std::mutex> lock(cacheLock);
+
+    cachedFiles.clear();
+    for (auto& [key, parsed] : parsedFiles) {
+        parsed.modificationTime = outdated;
+    }
+}
+
+void AbstractionCache::removeInstance(void* instance)
+{
+    std::lock_guard<std::mutex> lock(cacheLock);
+
+    for (auto it = parsedFiles.begin(); it != parsedFiles.end();) {
+        if (it->first.first == instance) {
+            binbuf_free(it->second.binbuf);
+            it = parsedFiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace pd
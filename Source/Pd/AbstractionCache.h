@@ -0,0 +1,36 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <m_pd.h>
+
+namespace pd {
+
+// Keeps the content of abstraction files in memory, so opening a patch with many copies of the same abstraction (like [clone 64 voice])
+// only reads and parses each file once
+// Files are shared by all instances, parsed binbufs are kept per pd instance because symbols can't be shared between instances
+// Entries are keyed on the absolute path and checked against the modification time of the file
+struct AbstractionCache {
+
+    // Registers the loader that creates abstractions from the cache, safe to call for every instance
+    static void initialise();
+
+    // Fills the binbuf with the content of the file, same as binbuf_read
+    // Returns 0 on success
+    static int read(t_binbuf* b, char const* filename, char const* dirname, int crflag);
+
+    // Call this when a file might have changed, without its modification time being updated yet
+    // Doesn't free anything, so it can be called while pd is loading a patch on another thread
+    static void invalidate(String const& path);
+
+    static void clear();
+
+    // Frees the binbufs that were parsed for this instance
+    static void removeInstance(void* instance);
+};
+
+} // namespace pd
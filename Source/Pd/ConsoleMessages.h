@@ -0,0 +1,118 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "Utility/StringUtils.h"
+
+namespace pd {
+
+// Console history, stored in a ring buffer that grows as messages come in, up to a maximum size
+// Every message gets an id that keeps increasing, so views can keep track of what they've already laid out while old messages get overwritten
+// Only use this from the message thread
+class ConsoleMessages {
+public:
+    struct Message {
+        void* object = nullptr;
+        String text;
+        int type = 0;
+        int repeats = 1;
+        int width = -1; // Computed when the message is first laid out
+    };
+
+    explicit ConsoleMessages(int maxMessages)
+        : maxMessages(maxMessages)
+        , fastStringWidth(Font(14))
+    {
+    }
+
+    // Repeats of the last message only increment its counter
+    bool isRepeat(void* object, String const& text, int type)
+    {
+        if (count == 0)
+            return false;
+
+        auto& last = get(getEndId() - 1);
+        return object == last.object && type == last.type && text == last.text;
+    }
+
+    void add(void* object, String const& text, int type)
+    {
+        if (isRepeat(object, text, type)) {
+            get(getEndId() - 1).repeats++;
+            return;
+        }
+
+        if (count == maxMessages) {
+            firstId++;
+            count--;
+
+            // Strings are shared through the pool, remove the ones that are no longer used every now and then
+            if (firstId % (maxMessages / 4) == 0)
+                stringPool.garbageCollect();
+        }
+
+        // Until the buffer is full, nothing has been overwritten yet, so ids still map directly to indices while it grows
+        if (static_cast<int>(messages.size()) < maxMessages)
+            messages.emplace_back();
+
+        auto& message = messages[(firstId + count) % messages.size()];
+        message.object = object;
+        message.text = stringPool.getPooledString(text);
+        message.type = type;
+        message.repeats = 1;
+        message.width = -1;
+        count++;
+    }
+
+    Message& get(int64 id)
+    {
+        jassert(id >= firstId && id < getEndId());
+        return messages[id % messages.size()];
+    }
+
+    // Width of the message in pixels, including padding
+    int getWidth(Message& message) const
+    {
+        if (message.width < 0)
+            message.width = fastStringWidth.getStringWidth(message.text) + 8;
+
+        return message.width;
+    }
+
+    int64 getEndId() const
+    {
+        return firstId + count;
+    }
+
+    // Messages before this id have been cleared from view, but can still be restored if they weren't overwritten yet
+    int64 getFirstVisibleId() const
+    {
+        return std::max(firstId, firstVisibleId);
+    }
+
+    void hideAll()
+    {
+        firstVisibleId = getEndId();
+    }
+
+    void restore()
+    {
+        firstVisibleId = firstId;
+    }
+
+private:
+    std::vector<Message> messages;
+    int maxMessages;
+    int64 firstId = 0;
+    int64 firstVisibleId = 0;
+    int count = 0;
+
+    StringPool stringPool;
+    StringUtils fastStringWidth;
+};
+
+} // namespace pd
@@ -24,6 +24,7 @@ extern "C" {
 
 #include "Pd/Interface.h"
 #include "Setup.h"
+#include "AbstractionCache.h"
 #include "z_print_util.h"
 
 EXTERN int sys_load_lib(t_canvas* canvas, char const* classname);
@@ -147,6 +148,8 @@ Instance::~Instance()
     // JYG added this
     pd_free(static_cast<t_pd*>(dataBufferReceiver));
 
+    AbstractionCache::removeInstance(instance);
+
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
     libpd_free_instance(static_cast<t_pdinstance*>(instance));
 }
@@ -276,15 +279,9 @@ void Instance::initialisePd(String& pdlua_version)
 
     static bool initialised = false;
     if (!initialised) {
-        set_class_prefix(gensym("else"));
-        class_set_extern_dir(gensym("9.else"));
-        pd::Setup::initialiseELSE();
-        set_class_prefix(gensym("cyclone"));
-        class_set_extern_dir(gensym("10.cyclone"));
-        pd::Setup::initialiseCyclone();
-
-        class_set_extern_dir(gensym(""));
-        set_class_prefix(nullptr);
+        auto classTable = ProjectInfo::versionDataDir.getChildFile("ClassTable.txt");
+        classTable.getParentDirectory().createDirectory();
+        pd::Setup::initialiseLibraries(classTable.getFullPathName().toRawUTF8(), ProjectInfo::versionString, lazyLibraries);
         initialised = true;
     }
     
@@ -299,6 +296,9 @@ void Instance::initialisePd(String& pdlua_version)
     if (*vers)
         pdlua_version = vers;
 
+    // After pdlua, so a .pd_lua file still takes precedence over an abstraction with the same name
+    AbstractionCache::initialise();
+
     // Hack to make sure ofelia doesn't get initialised during plugin validation, as this can cause problems
     MessageManager::callAsync([_this = juce::WeakReference(this)]() {
         if (!_this.get())
@@ -320,8 +320,31 @@ int Instance::getBlockSize() const
 
 void Instance::prepareDSP(int const nins, int const nouts, double const samplerate, int const blockSize)
 {
+    static_assert(std::is_same_v<t_sample, float>, "Pd's sound buffers are handed out as float buffers");
+
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
     libpd_init_audio(nins, nouts, static_cast<int>(samplerate));
+
+    // This reallocates Pd's sound buffers, so update our pointers into them
+    soundInputs.clear();
+    for (int ch = 0; ch < STUFF->st_inchannels; ch++) {
+        soundInputs.push_back(STUFF->st_soundin + (ch * DEFDACBLKSIZE));
+    }
+
+    soundOutputs.clear();
+    for (int ch = 0; ch < STUFF->st_outchannels; ch++) {
+        soundOutputs.push_back(STUFF->st_soundout + (ch * DEFDACBLKSIZE));
+    }
+}
+
+std::vector<float*> const& Instance::getSoundInputs() const
+{
+    return soundInputs;
+}
+
+std::vector<float*> const& Instance::getSoundOutputs() const
+{
+    return soundOutputs;
 }
 
 void Instance::startDSP()
@@ -339,10 +362,27 @@ void Instance::releaseDSP()
     libpd_message("pd", "dsp", 1, &av);
 }
 
-void Instance::performDSP(float const* inputs, float* outputs)
+// Processes one Pd block in place on Pd's own sound buffers
+// The compiled DSP chain reads from and adds into these buffers directly, so they can't be swapped for the host's buffers
+void Instance::performDSP()
 {
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
-    libpd_process_raw(inputs, outputs);
+
+    sys_lock();
+    sys_pollgui();
+
+    // GUI messages arrive at the start of the block, we already hold the pd lock for this
+    sendDirectMessagesFromQueue();
+
+    std::fill(STUFF->st_soundout, STUFF->st_soundout + (STUFF->st_outchannels * DEFDACBLKSIZE), 0);
+
+    sched_tick();
+
+    receiveDSPTick();
+
+    sys_unlock();
+
+    lastDSPTime.store(Time::getMillisecondCounter());
 }
 
 void Instance::sendNoteOn(int const channel, int const pitch, int const velocity) const
@@ -487,29 +527,17 @@ void Instance::processMessage(Message mess)
     }
 }
 
-void Instance::processSend(dmessage mess)
+void Instance::processDirectMessage(void* object, t_symbol* selector, int argc, t_atom* argv)
 {
-    if (auto obj = mess.object.get<t_pd>()) {
-        if (mess.selector == "list") {
-            auto* argv = static_cast<t_atom*>(atoms);
-            for (size_t i = 0; i < mess.list.size(); ++i) {
-                if (mess.list[i].isFloat())
-                    SETFLOAT(argv + i, mess.list[i].getFloat());
-                else if (mess.list[i].isSymbol()) {
-                    SETSYMBOL(argv + i, mess.list[i].getSymbol());
-                } else
-                    SETFLOAT(argv + i, 0.0);
-            }
-            pd_list(obj.get(), generateSymbol("list"), static_cast<int>(mess.list.size()), argv);
-        } else if (mess.selector == "float" && !mess.list.empty() && mess.list[0].isFloat()) {
-            pd_float(obj.get(), mess.list[0].getFloat());
-        } else if (mess.selector == "symbol" && !mess.list.empty() && mess.list[0].isSymbol()) {
-            pd_symbol(obj.get(), mess.list[0].getSymbol());
-        } else {
-            sendTypedMessage(obj.get(), mess.selector.toRawUTF8(), mess.list);
-        }
+    auto* obj = static_cast<t_pd*>(object);
+    if (selector == &s_list) {
+        pd_list(obj, &s_list, argc, argv);
+    } else if (selector == &s_float && argc && argv[0].a_type == A_FLOAT) {
+        pd_float(obj, atom_getfloat(argv));
+    } else if (selector == &s_symbol && argc && argv[0].a_type == A_SYMBOL) {
+        pd_symbol(obj, atom_getsymbol(argv));
     } else {
-        sendMessage(mess.destination.toRawUTF8(), mess.selector.toRawUTF8(), mess.list);
+        pd_typedmess(obj, selector, argc, argv);
     }
 }
 
@@ -548,11 +576,19 @@ void Instance::unregisterWeakReference(void* ptr, pd_weak_reference const* ref)
 void Instance::clearWeakReferences(void* ptr)
 {
     weakReferenceMutex.lock();
-    for (auto* ref : pdWeakReferences[ptr]) {
-        *ref = false;
+    auto it = pdWeakReferences.find(ptr);
+    bool const hadReferences = it != pdWeakReferences.end() && !it->second.empty();
+    if (it != pdWeakReferences.end()) {
+        for (auto* ref : it->second) {
+            *ref = false;
+        }
+        pdWeakReferences.erase(it);
     }
-    pdWeakReferences.erase(ptr);
     weakReferenceMutex.unlock();
+
+    // The object gets freed after this returns, so wait for GUI reads that might still be looking at it
+    if (hadReferences)
+        readHazards.synchronise(ptr);
 }
 
 void Instance::enqueueFunctionAsync(std::function<void(void)> const& fn)
@@ -560,32 +596,111 @@ void Instance::enqueueFunctionAsync(std::function<void(void)> const& fn)
     functionQueue.enqueue(fn);
 }
 
-void Instance::sendDirectMessage(void* object, String const& msg, std::vector<Atom>&& list)
+void Instance::sendDirectMessage(WeakReference const& object, String const& msg, std::vector<Atom>&& list)
 {
-    lockAudioThread();
-    processSend(dmessage(this, object, String(), msg, std::move(list)));
-    unlockAudioThread();
+    enqueueDirectMessage(object, generateSymbol(msg), list);
 }
 
-void Instance::sendDirectMessage(void* object, std::vector<Atom>&& list)
+void Instance::sendDirectMessage(WeakReference const& object, std::vector<Atom>&& list)
 {
-    lockAudioThread();
-    processSend(dmessage(this, object, String(), "list", std::move(list)));
-    unlockAudioThread();
+    enqueueDirectMessage(object, generateSymbol("list"), list);
 }
 
-void Instance::sendDirectMessage(void* object, String const& msg)
+void Instance::sendDirectMessage(WeakReference const& object, String const& msg)
 {
+    enqueueDirectMessage(object, generateSymbol("symbol"), std::vector<Atom>(1, generateSymbol(msg)));
+}
 
-    lockAudioThread();
-    processSend(dmessage(this, object, String(), "symbol", std::vector<Atom>(1, generateSymbol(msg))));
-    unlockAudioThread();
+void Instance::sendDirectMessage(WeakReference const& object, float const msg)
+{
+    enqueueDirectMessage(object, generateSymbol("float"), std::vector<Atom>(1, msg));
 }
 
-void Instance::sendDirectMessage(void* object, float const msg)
+void Instance::enqueueDirectMessage(WeakReference const& object, t_symbol* selector, std::vector<Atom> const& list)
+{
+    // Only the message thread is allowed to produce direct messages
+    jassert(MessageManager::existsAndIsCurrentThread());
+
+    // Callers that hold a pd lock often read back the state right after sending, so those get the message delivered right away
+    if (threadLockDepth == 0) {
+        if (auto* message = directMessageQueue.getNextSlot(list.size())) {
+            if (!registerDirectMessage(*message, object))
+                return;
+
+            message->selector = selector;
+            message->argc = static_cast<int>(list.size());
+            for (int i = 0; i < message->argc; i++) {
+                if (list[i].isFloat())
+                    SETFLOAT(message->argv + i, list[i].getFloat());
+                else
+                    SETSYMBOL(message->argv + i, list[i].getSymbol());
+            }
+            directMessageQueue.publish();
+
+            // If the audio thread isn't running, nobody will drain the queue, so deliver it right away
+            if (Time::getMillisecondCounter() - lastDSPTime.load() > 100)
+                flushDirectMessages();
+
+            return;
+        }
+    }
+
+    // The caller holds a pd lock, the message is too long for a preallocated slot, or the queue is full: deliver it under the audio lock
+    if (auto obj = object.get<void>()) {
+        // Flush the queue first to make sure messages arrive in order
+        sendDirectMessagesFromQueue();
+
+        auto argv = std::vector<t_atom>(list.size());
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (list[i].isFloat())
+                SETFLOAT(argv.data() + i, list[i].getFloat());
+            else
+                SETSYMBOL(argv.data() + i, list[i].getSymbol());
+        }
+        processDirectMessage(obj.get(), selector, static_cast<int>(argv.size()), argv.data());
+    }
+}
+
+// Makes the slot a weak reference to the object, returns false if the object was already freed
+// Checking the object and registering the slot happen under the same mutex that freeing an object takes, so it can't be freed in between
+// The slot stays registered until it's reused, so the audio thread never has to touch the weak reference map
+bool Instance::registerDirectMessage(DirectMessageQueue::Message& message, WeakReference const& object)
+{
+    std::lock_guard<std::recursive_mutex> lock(weakReferenceMutex);
+
+    if (message.object) {
+        auto it = pdWeakReferences.find(message.object);
+        if (it != pdWeakReferences.end()) {
+            auto& refs = it->second;
+            refs.erase(std::remove(refs.begin(), refs.end(), &message.alive), refs.end());
+        }
+        message.object = nullptr;
+    }
+
+    if (!object.isValid())
+        return false;
+
+    message.object = object.getRawUnchecked<void>();
+    message.alive = true;
+    pdWeakReferences[message.object].push_back(&message.alive);
+    return true;
+}
+
+// Only call this while holding the pd lock
+void Instance::sendDirectMessagesFromQueue()
+{
+    while (auto* message = directMessageQueue.front()) {
+        if (message->alive)
+            processDirectMessage(message->object, message->selector, message->argc, message->argv);
+        directMessageQueue.pop();
+    }
+}
+
+void Instance::flushDirectMessages()
 {
     lockAudioThread();
-    processSend(dmessage(this, object, String(), "float", std::vector<Atom>(1, msg)));
+    setThis();
+    sendDirectMessagesFromQueue();
     unlockAudioThread();
 }
 
@@ -668,14 +783,14 @@ void Instance::muteConsole(bool shouldMute)
     consoleMute = shouldMute;
 }
 
-std::deque<std::tuple<void*, String, int, int, int>>& Instance::getConsoleMessages()
+ConsoleMessages& Instance::getConsoleMessages()
 {
     return consoleHandler.consoleMessages;
 }
 
-std::deque<std::tuple<void*, String, int, int, int>>& Instance::getConsoleHistory()
+void Instance::setConsoleRateLimit(int messagesPerSecond)
 {
-    return consoleHandler.consoleHistory;
+    consoleHandler.rateLimit = messagesPerSecond;
 }
 
 void Instance::createPanel(int type, char const* snd, char const* location, char const* callbackName, int openMode)
@@ -759,11 +874,13 @@ bool Instance::loadLibrary(String const& libraryToLoad)
 void Instance::lockAudioThread()
 {
     audioLock.enter();
+    threadLockDepth++;
 }
 
 bool Instance::tryLockAudioThread()
 {
     if (audioLock.tryEnter()) {
+        threadLockDepth++;
         return true;
     }
 
@@ -772,6 +889,7 @@ bool Instance::tryLockAudioThread()
 
 void Instance::unlockAudioThread()
 {
+    threadLockDepth--;
     audioLock.exit();
 }
 
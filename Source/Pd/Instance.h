@@ -14,6 +14,7 @@ extern "C" {
 #include <concurrentqueue.h>
 #include <readerwriterqueue.h>
 #include "Utility/StringUtils.h"
+#include "ConsoleMessages.h"
 #include "Patch.h"
 #include "Ofelia.h"
 
@@ -142,20 +143,60 @@ class Instance {
         std::vector<pd::Atom> list;
     };
 
-    struct dmessage {
+    // Wait-free single-producer/single-consumer ring of preallocated messages
+    // The message thread pushes GUI messages without taking the audio lock, the audio thread drains them in performDSP, while it holds the pd lock anyway
+    struct DirectMessageQueue {
+        static constexpr int maxAtoms = 8;
+        static constexpr uint32 capacity = 512;
+
+        struct Message {
+            void* object = nullptr;
+            pd_weak_reference alive = false; // Registered as a weak reference to the object, so it turns false when the object is freed before delivery
+            t_symbol* selector;
+            int argc;
+            t_atom argv[maxAtoms];
+        };
+
+        // Returns the slot to write the next message into, or nullptr if the queue is full or the message is too long
+        // The slot is only delivered after calling publish()
+        Message* getNextSlot(size_t numAtoms)
+        {
+            auto const write = writeIndex.load(std::memory_order_relaxed);
+            if (write - readIndex.load(std::memory_order_acquire) >= capacity || numAtoms > maxAtoms)
+                return nullptr;
+
+            return &messages[write & (capacity - 1)];
+        }
 
-        dmessage(pd::Instance* instance, void* ref, String dest, String sel, std::vector<pd::Atom> atoms)
-            : object(ref, instance)
-            , destination(dest)
-            , selector(sel)
-            , list(atoms)
+        void publish()
         {
+            writeIndex.store(writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
         }
 
-        WeakReference object;
-        String destination;
-        String selector;
-        std::vector<pd::Atom> list;
+        // Only call these while holding the audio lock: that serialises the consumers
+        Message* front()
+        {
+            auto const read = readIndex.load(std::memory_order_relaxed);
+            if (read == writeIndex.load(std::memory_order_acquire))
+                return nullptr;
+
+            return &messages[read & (capacity - 1)];
+        }
+
+        void pop()
+        {
+            readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        bool isEmpty() const
+        {
+            return readIndex.load(std::memory_order_acquire) == writeIndex.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::array<Message, capacity> messages;
+        std::atomic<uint32> readIndex = 0;
+        std::atomic<uint32> writeIndex = 0;
     };
 
 public:
@@ -167,9 +208,14 @@ public:
     void prepareDSP(int nins, int nouts, double samplerate, int blockSize);
     void startDSP();
     void releaseDSP();
-    void performDSP(float const* inputs, float* outputs);
+    void performDSP();
     int getBlockSize() const;
 
+    // Pd's own adc~ and dac~ buffers, one block per channel, which performDSP reads from and writes to
+    // They are reallocated by prepareDSP, so don't hold on to them after calling that
+    std::vector<float*> const& getSoundInputs() const;
+    std::vector<float*> const& getSoundOutputs() const;
+
     void sendNoteOn(int channel, int const pitch, int velocity) const;
     void sendControlChange(int channel, int const controller, int value) const;
     void sendProgramChange(int channel, int value) const;
@@ -231,6 +277,9 @@ public:
 
     virtual void receiveDSPState(bool dsp) { }
 
+    // Called on the audio thread after every pd block, while pd is still locked
+    virtual void receiveDSPTick() { }
+
     virtual void updateConsole(int numMessages, bool newWarning) { }
 
     virtual void titleChanged() { }
@@ -250,10 +299,16 @@ public:
         });
     }
 
-    void sendDirectMessage(void* object, String const& msg, std::vector<Atom>&& list);
-    void sendDirectMessage(void* object, std::vector<pd::Atom>&& list);
-    void sendDirectMessage(void* object, String const& msg);
-    void sendDirectMessage(void* object, float msg);
+    // Queued for the next pd block, unless the calling thread holds a pd lock, then it's delivered right away
+    // Queued for the start of the next Pd block, call these outside of a WeakReference::get() scope
+    // Inside one they are delivered right away, under the audio lock
+    void sendDirectMessage(WeakReference const& object, String const& msg, std::vector<Atom>&& list);
+    void sendDirectMessage(WeakReference const& object, std::vector<pd::Atom>&& list);
+    void sendDirectMessage(WeakReference const& object, String const& msg);
+    void sendDirectMessage(WeakReference const& object, float msg);
+
+    // Delivers the queued direct messages from the message thread, for when pd's state has to be read back right after
+    void flushDirectMessages();
 
     void updateObjectImplementations();
     void clearObjectImplementationsForPatch(pd::Patch* p);
@@ -269,12 +324,13 @@ public:
     void logWarning(String const& message);
     void muteConsole(bool shouldMute);
 
-    std::deque<std::tuple<void*, String, int, int, int>>& getConsoleMessages();
-    std::deque<std::tuple<void*, String, int, int, int>>& getConsoleHistory();
+    ConsoleMessages& getConsoleMessages();
+
+    // Maximum number of console messages per second for each object, zero means no limit
+    void setConsoleRateLimit(int messagesPerSecond);
 
     void sendMessagesFromQueue();
     void processMessage(Message mess);
-    void processSend(dmessage mess);
 
     String getExtraInfo(File const& toOpen);
     Patch::Ptr openPatch(File const& toOpen);
@@ -310,9 +366,13 @@ public:
 
     inline static String const defaultPatch = "#N canvas 827 239 527 327 12;";
 
+    // Only set up ELSE and cyclone classes when they're first used. Has to be set before the first instance is created
+    inline static bool lazyLibraries = true;
+
     bool isPerformingGlobalSync = false;
     CriticalSection const audioLock;
     std::recursive_mutex weakReferenceMutex;
+    ReadHazards readHazards;
 
 private:
     std::unordered_map<void*, std::vector<pd_weak_reference*>> pdWeakReferences;
@@ -321,6 +381,17 @@ private:
 
     moodycamel::ConcurrentQueue<std::function<void(void)>> functionQueue = moodycamel::ConcurrentQueue<std::function<void(void)>>(4096);
 
+    void enqueueDirectMessage(WeakReference const& object, t_symbol* selector, std::vector<pd::Atom> const& list);
+    bool registerDirectMessage(DirectMessageQueue::Message& message, WeakReference const& object);
+    void sendDirectMessagesFromQueue();
+    void processDirectMessage(void* object, t_symbol* selector, int argc, t_atom* argv);
+
+    DirectMessageQueue directMessageQueue;
+    std::atomic<uint32> lastDSPTime = 0;
+
+    std::vector<float*> soundInputs;
+    std::vector<float*> soundOutputs;
+
     std::unique_ptr<FileChooser> openChooser;
     std::atomic<bool> consoleMute;
     static inline std::set<hash32> luaClasses = std::set<hash32>(); // Keep track of class names that correspond to pdlua objects
@@ -335,7 +406,6 @@ protected:
 
         ConsoleHandler(Instance* parent)
             : instance(parent)
-            , fastStringWidth(Font(14))
         {
         }
 
@@ -347,41 +417,100 @@ protected:
 
             while (pendingMessages.try_dequeue(item)) {
                 auto& [object, message, type] = item;
-                addMessage(object, message, type);
-
+                consoleMessages.add(object, message, type);
                 numReceived++;
                 newWarning = newWarning || type;
             }
 
+            auto const [numReported, stillSuppressing] = reportSuppressedMessages();
+            numReceived += numReported;
+
             // Check if any item got assigned
             if (numReceived) {
-                instance->updateConsole(numReceived, newWarning);
+                instance->updateConsole(numReceived, newWarning || numReported);
+            }
+
+            // Keep checking until all floods are reported
+            if (stillSuppressing)
+                startTimer(250);
+            else
+                stopTimer();
+        }
+
+        // Called by the thread that prints, before the message is converted to a String or queued
+        // Returns false if the object has printed more than rateLimit different messages in the last second
+        bool checkRateLimit(void* object, char const* message)
+        {
+            auto const limit = rateLimit.load(std::memory_order_relaxed);
+            if (limit <= 0)
+                return true;
+
+            auto& rate = sourceRates[(reinterpret_cast<uintptr_t>(object) >> 4) % numSourceRates];
+            auto const now = Time::getMillisecondCounter();
+
+            if (rate.object.load() != object) {
+                // Another object takes over this slot, so report what the previous one was suppressing right away
+                if (auto const numSuppressed = rate.numSuppressed.exchange(0); numSuppressed > 0)
+                    pendingMessages.enqueue({ rate.object.load(), getSuppressedText(numSuppressed), true });
+
+                rate.object = object;
+                rate.windowStart = now;
+                rate.numMessages = 0;
+                rate.lastMessageHash = 0;
+            } else if (now - rate.windowStart.load() >= 1000) {
+                rate.windowStart = now;
+                rate.numMessages = 0;
             }
 
-            stopTimer();
+            // Repeated messages are cheap, they only increase a counter in the console
+            auto const messageHash = hash(message);
+            auto const isRepeat = messageHash == rate.lastMessageHash;
+            rate.lastMessageHash = messageHash;
+
+            if (isRepeat || ++rate.numMessages <= limit)
+                return true;
+
+            if (rate.numSuppressed.fetch_add(1) == 0)
+                startTimer(250);
+
+            return false;
         }
 
-        void addMessage(void* object, String const& message, bool type)
+        // Once a source has been quiet for a while, add a single message with the number of messages we dropped
+        // Returns the number of messages that were added, and whether there are sources left that are still suppressing
+        std::pair<int, bool> reportSuppressedMessages()
         {
-            if (consoleMessages.size()) {
-                auto& [lastObject, lastMessage, lastType, lastLength, numMessages] = consoleMessages.back();
-                if (object == lastObject && message == lastMessage && type == lastType) {
-                    numMessages++;
-                } else {
-                    consoleMessages.emplace_back(object, message, type, fastStringWidth.getStringWidth(message) + 8, 1);
+            int numReported = 0;
+            bool stillSuppressing = false;
+            auto const now = Time::getMillisecondCounter();
+
+            for (auto& rate : sourceRates) {
+                if (rate.numSuppressed.load() == 0)
+                    continue;
+
+                if (now - rate.windowStart.load() < 1000) {
+                    stillSuppressing = true;
+                    continue;
+                }
+
+                if (auto const numSuppressed = rate.numSuppressed.exchange(0); numSuppressed > 0) {
+                    consoleMessages.add(rate.object.load(), getSuppressedText(numSuppressed), 1);
+                    numReported++;
                 }
-            } else {
-                consoleMessages.emplace_back(object, message, type, fastStringWidth.getStringWidth(message) + 8, 1);
             }
 
-            if (consoleMessages.size() > 800)
-                consoleMessages.pop_front();
+            return { numReported, stillSuppressing };
+        }
+
+        static String getSuppressedText(int numSuppressed)
+        {
+            return String(numSuppressed) + " messages were not shown, because this object was printing too fast";
         }
 
         void logMessage(void* object, String const& message)
         {
             if (MessageManager::getInstance()->isThisTheMessageThread()) {
-                addMessage(object, message, false);
+                consoleMessages.add(object, message, false);
                 instance->updateConsole(1, false);
             } else {
                 pendingMessages.enqueue({ object, message, false });
@@ -392,7 +521,7 @@ protected:
         void logWarning(void* object, String const& warning)
         {
             if (MessageManager::getInstance()->isThisTheMessageThread()) {
-                addMessage(object, warning, true);
+                consoleMessages.add(object, warning, true);
                 instance->updateConsole(1, true);
             } else {
                 pendingMessages.enqueue({ object, warning, true });
@@ -403,7 +532,7 @@ protected:
         void logError(void* object, String const& error)
         {
             if (MessageManager::getInstance()->isThisTheMessageThread()) {
-                addMessage(object, error, true);
+                consoleMessages.add(object, error, true);
                 instance->updateConsole(1, true);
             } else {
                 pendingMessages.enqueue({ object, error, true });
@@ -413,8 +542,12 @@ protected:
 
         void processPrint(void* object, char const* message)
         {
-            std::function<void(String const)> forwardMessage =
-                [this, object](String const& message) {
+            std::function<void(char const*)> forwardMessage =
+                [this, object](char const* line) {
+                    if (!checkRateLimit(object, line))
+                        return;
+
+                    auto const message = String::fromUTF8(line);
                     if (message.startsWith("error")) {
                         logError(object, message.substring(7));
                     } else if (message.startsWith("verbose(0):") || message.startsWith("verbose(1):")) {
@@ -437,7 +570,7 @@ protected:
                 strncat(printConcatBuffer, message, d);
 
                 // Send concatenated line to plugdata!
-                forwardMessage(String::fromUTF8(printConcatBuffer));
+                forwardMessage(printConcatBuffer);
 
                 message += d;
                 len -= d;
@@ -452,20 +585,32 @@ protected:
                 printConcatBuffer[length - 1] = '\0';
 
                 // Send concatenated line to plugdata!
-                forwardMessage(String::fromUTF8(printConcatBuffer));
+                forwardMessage(printConcatBuffer);
 
                 length = 0;
             }
         }
 
-        std::deque<std::tuple<void*, String, int, int, int>> consoleMessages;
-        std::deque<std::tuple<void*, String, int, int, int>> consoleHistory;
+        // Message rate of an object in the current one second window
+        // Only the thread that prints writes these, the console timer reads the window and takes the suppressed count
+        struct SourceRate {
+            std::atomic<void*> object = nullptr;
+            std::atomic<uint32> windowStart = 0;
+            std::atomic<int> numSuppressed = 0;
+            int numMessages = 0;
+            hash32 lastMessageHash = 0;
+        };
+
+        ConsoleMessages consoleMessages = ConsoleMessages(1 << 18);
+
+        // Objects are spread over a fixed number of slots, so the printing thread never allocates to count them
+        static constexpr int numSourceRates = 256;
+        SourceRate sourceRates[numSourceRates];
+        std::atomic<int> rateLimit = 0;
 
         char printConcatBuffer[2048];
 
         moodycamel::ReaderWriterQueue<std::tuple<void*, String, bool>> pendingMessages;
-
-        StringUtils fastStringWidth; // For formatting console messages more quickly
     };
 
     std::unique_ptr<Ofelia> ofelia;
@@ -44,6 +44,8 @@ extern void set_class_prefix(t_symbol*);
 extern void clear_class_loadsym();
 }
 
+#include <functional>
+
 namespace pd {
 
 struct Interface {
@@ -521,6 +523,16 @@ struct Interface {
     }
 
     static void getCanvasContent(t_canvas* cnv, char** buf, int* bufsize)
+    {
+        t_binbuf* b = getCanvasBinbuf(cnv);
+        binbuf_gettext(b, buf, bufsize);
+        binbuf_free(b);
+    }
+
+    // Saves the canvas into a new binbuf, without converting it to text
+    // Converting to text doesn't need the Pd lock, so it can happen on another thread. The caller has to free the binbuf
+    // saveObject can replace gobj_save for the objects on this canvas, to reuse what was saved before
+    static t_binbuf* getCanvasBinbuf(t_canvas* cnv, std::function<void(t_gobj*, t_binbuf*)> const& saveObject = nullptr)
     {
         t_binbuf* b = binbuf_new();
 
@@ -554,8 +566,12 @@ struct Interface {
                 (int)cnv->gl_font);
             canvas_savedeclarationsto(cnv, b);
         }
-        for (y = cnv->gl_list; y; y = y->g_next)
-            gobj_save(y, b);
+        for (y = cnv->gl_list; y; y = y->g_next) {
+            if (saveObject)
+                saveObject(y, b);
+            else
+                gobj_save(y, b);
+        }
 
         linetraverser_start(&t, cnv);
         while ((oc = linetraverser_next(&t))) {
@@ -591,8 +607,7 @@ struct Interface {
                     (t_float)cnv->gl_isgraph);
         }
 
-        binbuf_gettext(b, buf, bufsize);
-        binbuf_free(b);
+        return b;
     }
 
     static int numOutlets(t_object const* x)
@@ -13,6 +13,8 @@
 #include <BinaryData.h>
 
 #include "Utility/OSUtils.h"
+#include "Utility/SettingsFile.h"
+#include "AbstractionCache.h"
 
 extern "C" {
 #include <m_pd.h>
@@ -26,6 +28,7 @@ extern "C" {
 #include "Library.h"
 #include "Instance.h"
 #include "Pd/Interface.h"
+#include "Pd/Setup.h"
 
 struct _canvasenvironment {
     t_symbol* ce_dir;    /* directory patch lives in */
@@ -39,9 +42,9 @@ namespace pd {
 
 void Library::updateLibrary()
 {
-    auto settingsTree = ValueTree::fromXml(ProjectInfo::appDataDir.getChildFile(".settings").loadFileAsString());
-    auto pathTree = settingsTree.getChildWithName("Paths");
+    StringArray classes;
 
+    // Only hold the pd lock while copying the class names, scanning the search paths happens on a background thread
     sys_lock();
 
     // Get available objects directly from pd
@@ -50,8 +53,6 @@ void Library::updateLibrary()
     auto* mlist = static_cast<t_methodentry*>(libpd_get_class_methods(o));
     t_methodentry* m;
 
-    allObjects.clear();
-
     int i;
     for (i = o->c_nmethod, m = mlist; i--; m++) {
         if (!m || !m->me_name)
@@ -59,56 +60,123 @@ void Library::updateLibrary()
 
         auto newName = String::fromUTF8(m->me_name->s_name);
         if (!(newName.startsWith("else/") || newName.startsWith("cyclone/") || newName.endsWith("_aliased"))) {
-            allObjects.add(newName);
+            classes.add(newName);
         }
     }
 
-    // Find patches in our search tree
-    for (auto path : pathTree) {
-        auto filePath = path.getProperty("Path").toString();
+    // Library classes that haven't been created yet aren't registered with pd
+    for (auto const& name : Setup::getLazyClassNames()) {
+        auto newName = String::fromUTF8(name.c_str());
+        if (!(newName.startsWith("else/") || newName.startsWith("cyclone/") || newName.endsWith("_aliased"))) {
+            classes.add(newName);
+        }
+    }
 
-        auto file = File(filePath);
-        if (!file.exists() || !file.isDirectory())
-            continue;
+    sys_unlock();
 
-        for (auto const& file : OSUtils::iterateDirectory(file, false, true)) {
-            if (file.hasFileExtension("pd")) {
-                auto filename = file.getFileNameWithoutExtension();
-                if (!filename.startsWith("help-") || filename.endsWith("-help")) {
-                    allObjects.add(filename);
-                }
-            }
+    Array<File> paths;
+    for (auto path : SettingsFile::getInstance()->getPathsTree()) {
+        paths.add(File(path.getProperty("Path").toString()));
+    }
+
+    // Watch the search paths, so we can update the index when patches are added or removed
+    for (auto const& folder : watcher.getWatchedFolders()) {
+        if (folder != ProjectInfo::appDataDir && !paths.contains(folder))
+            watcher.removeFolder(folder);
+    }
+    auto const watchedFolders = watcher.getWatchedFolders();
+    for (auto const& path : paths) {
+        if (path.isDirectory() && !watchedFolders.contains(path))
+            watcher.addFolder(path);
+    }
+
+    objectSearchThread.addJob([this, classes, paths]() {
+        classNames = classes;
+        searchPaths = paths;
+        updateObjectList(true);
+    });
+}
+
+void Library::updateObjectList(bool rescan)
+{
+    auto objects = classNames;
+
+    // Find patches in our search tree
+    std::set<String> visited;
+    for (auto const& path : searchPaths) {
+        if (path.isDirectory())
+            addPatchesInDirectory(path, objects, rescan, visited);
+    }
+
+    if (rescan) {
+        for (auto it = directoryIndex.begin(); it != directoryIndex.end();) {
+            if (!visited.contains(it->first))
+                it = directoryIndex.erase(it);
+            else
+                ++it;
         }
     }
 
     // These can't be created by name in Pd, but plugdata allows it
-    allObjects.add("graph");
-    allObjects.add("garray");
-    
+    objects.add("graph");
+    objects.add("garray");
 
     // These aren't in there but should be
-    allObjects.add("float");
-    allObjects.add("symbol");
-    allObjects.add("list");
+    objects.add("float");
+    objects.add("symbol");
+    objects.add("list");
 
-    sys_unlock();
+    {
+        std::lock_guard<std::recursive_mutex> lock(libraryLock);
+        allObjects = objects;
+    }
+
+    searchIndex.setObjects(objects);
 }
 
-Library::Library(pd::Instance* instance)
+// Directories are only listed again when their modification time changed, which happens when a file in it is added, removed or renamed
+void Library::addPatchesInDirectory(File const& directory, StringArray& objects, bool rescan, std::set<String>& visited)
 {
-    MemoryInputStream instream(BinaryData::Documentation_bin, BinaryData::Documentation_binSize, false);
-    documentationTree = ValueTree::readFromStream(instream);
-
-    for (auto object : documentationTree) {
-        auto categories = object.getChildWithName("categories");
-        if (!categories.isValid())
-            continue;
+    auto const path = directory.getFullPathName();
+    if (!visited.insert(path).second)
+        return;
 
-        for (auto category : categories) {
-            allCategories.addIfNotAlreadyThere(category.getProperty("name").toString());
+    auto& indexed = directoryIndex[path];
+    if (rescan) {
+        auto const modificationTime = directory.getLastModificationTime();
+        if (!indexed.scanned || modificationTime != indexed.modificationTime) {
+            indexed.scanned = true;
+            indexed.modificationTime = modificationTime;
+            indexed.patches.clear();
+
+            // Only the directory itself, pd doesn't look in subdirectories of a search path either
+            for (auto const& file : OSUtils::iterateDirectory(directory, false, true)) {
+                if (isPatchObject(file))
+                    indexed.patches.add(file.getFileNameWithoutExtension());
+            }
         }
     }
 
+    objects.addArray(indexed.patches);
+}
+
+bool Library::isPatchObject(File const& file)
+{
+    if (!file.hasFileExtension("pd"))
+        return false;
+
+    auto filename = file.getFileNameWithoutExtension();
+    return !filename.startsWith("help-") || filename.endsWith("-help");
+}
+
+Library::Library(pd::Instance* instance)
+    : documentation(ObjectDocumentation::getShared())
+{
+    // Tokenising all the documentation takes a while, so build that part of the index in the background
+    objectSearchThread.addJob([this]() {
+        searchIndex.setDocumentation(documentation->getSearchWords());
+    });
+
     watcher.addFolder(ProjectInfo::appDataDir);
     watcher.addListener(this);
 
@@ -136,27 +204,40 @@ Library::Library(pd::Instance* instance)
     });
 }
 
-StringArray Library::autocomplete(String const& query, File const& patchDirectory) const
+StringArray Library::autocomplete(String const& query, File const& currentPatchDirectory) const
 {
     StringArray result;
     result.ensureStorageAllocated(20);
 
-    if (patchDirectory.isDirectory()) {
-        for (auto const& file : OSUtils::iterateDirectory(patchDirectory, false, true, 20)) {
-            auto filename = file.getFileNameWithoutExtension();
-            if (file.hasFileExtension("pd") && filename.startsWith(query) && !filename.startsWith("help-") && !filename.endsWith("-help")) {
+    if (currentPatchDirectory.isDirectory()) {
+        std::lock_guard<std::mutex> lock(patchDirectoryLock);
+
+        auto const modificationTime = currentPatchDirectory.getLastModificationTime();
+        if (currentPatchDirectory != patchDirectory || modificationTime != patchDirectoryModificationTime) {
+            patchDirectory = currentPatchDirectory;
+            patchDirectoryModificationTime = modificationTime;
+            patchDirectoryObjects.clear();
+
+            for (auto const& file : OSUtils::iterateDirectory(currentPatchDirectory, false, true, 20)) {
+                auto filename = file.getFileNameWithoutExtension();
+                if (file.hasFileExtension("pd") && !filename.startsWith("help-") && !filename.endsWith("-help")) {
+                    patchDirectoryObjects.add(filename);
+                }
+            }
+        }
+
+        for (auto const& filename : patchDirectoryObjects) {
+            if (filename.startsWith(query)) {
                 result.add(filename);
             }
         }
     }
 
-    for (auto const& str : allObjects) {
+    for (auto const& name : searchIndex.findByPrefix(query, 20)) {
         if (result.size() >= 20)
             break;
 
-        if (str.startsWith(query)) {
-            result.addIfNotAlreadyThere(str);
-        }
+        result.addIfNotAlreadyThere(name);
     }
 
     return result;
@@ -170,39 +251,7 @@ void Library::getExtraSuggestions(int currentNumSuggestions, String const& query
         return;
 
     objectSearchThread.addJob([this, callback, query]() mutable {
-        StringArray result;
-        StringArray matches;
-
-        for (const auto& object : getAllObjects()) {
-            auto info = getObjectInfo(object);
-
-            auto description = info.getProperty("description").toString();
-
-            auto iolets = info.getChildWithName("iolets");
-            auto arguments = info.getChildWithName("arguments");
-
-            if (description.contains(query) || object.contains(query)) {
-                matches.addIfNotAlreadyThere(object);
-            }
-
-            for (auto arg : arguments) {
-                auto argDescription = arg.getProperty("description").toString();
-                if (argDescription.contains(query)) {
-                    matches.addIfNotAlreadyThere(object);
-                }
-            }
-
-            for (auto iolet : iolets) {
-                auto ioletDescription = iolet.getProperty("description").toString();
-                if (description.contains(query)) {
-                    matches.addIfNotAlreadyThere(object);
-                }
-            }
-        }
-
-        matches.sort(true);
-        result.addArray(matches);
-        matches.clear();
+        auto result = searchIndex.search(query, 50);
 
         MessageManager::callAsync([callback, result]() {
             callback(result);
@@ -210,41 +259,35 @@ void Library::getExtraSuggestions(int currentNumSuggestions, String const& query
     });
 }
 
-ValueTree Library::getObjectInfo(String const& name)
+ValueTree Library::getObjectInfo(String const& name) const
 {
-    return documentationTree.getChildWithProperty("name", name);
+    if (auto const* entry = documentation->getEntry(name))
+        return entry->tree;
+
+    return {};
 }
 
-std::array<StringArray, 2> Library::parseIoletTooltips(ValueTree const& iolets, String const& name, int numIn, int numOut)
+std::array<StringArray, 2> Library::parseIoletTooltips(String const& objectType, String const& name, int numIn, int numOut) const
 {
     std::array<StringArray, 2> result;
-    Array<std::pair<String, bool>> inlets;
-    Array<std::pair<String, bool>> outlets;
-
-    auto args = StringArray::fromTokens(name.fromFirstOccurrenceOf(" ", false, false), true);
 
-    for (auto iolet : iolets) {
-        auto isVariable = iolet.getProperty("variable").toString() == "1";
-        auto tooltip = iolet.getProperty("tooltip");
-        if (iolet.getType() == Identifier("inlet")) {
-            inlets.add({ tooltip, isVariable });
-        }
+    auto const* entry = documentation->getEntry(objectType);
+    if (!entry)
+        return result;
 
-        if (iolet.getType() == Identifier("outlet")) {
-            outlets.add({ tooltip, isVariable });
-        }
-    }
+    auto args = StringArray::fromTokens(name.fromFirstOccurrenceOf(" ", false, false), true);
 
     for (int type = 0; type < 2; type++) {
         int total = type ? numOut : numIn;
-        auto& descriptions = type ? outlets : inlets;
+        auto const& descriptions = entry->iolets[type];
+        int const numDescriptions = static_cast<int>(descriptions.size());
         // if the amount of inlets is not equal to the amount in the spec, look for repeating iolets
-        if (descriptions.size() < total) {
-            for (int i = 0; i < descriptions.size(); i++) {
-                if (descriptions[i].second) { // repeating inlet found
-                    for (int j = 0; j < (total - descriptions.size()) + 1; j++) {
+        if (numDescriptions < total) {
+            for (int i = 0; i < numDescriptions; i++) {
+                if (descriptions[i].isVariable) { // repeating inlet found
+                    for (int j = 0; j < (total - numDescriptions) + 1; j++) {
 
-                        auto description = descriptions[i].first;
+                        auto description = descriptions[i].tooltip;
                         description = description.replace("$mth", String(j));
                         description = description.replace("$nth", String(j + 1));
 
@@ -255,12 +298,12 @@ std::array<StringArray, 2> Library::parseIoletTooltips(ValueTree const& iolets,
                         result[type].add(description);
                     }
                 } else {
-                    result[type].add(descriptions[i].first);
+                    result[type].add(descriptions[i].tooltip);
                 }
             }
         } else {
-            for (auto&& description : descriptions) {
-                result[type].add(description.first);
+            for (auto const& description : descriptions) {
+                result[type].add(description.tooltip);
             }
         }
     }
@@ -270,12 +313,13 @@ std::array<StringArray, 2> Library::parseIoletTooltips(ValueTree const& iolets,
 
 StringArray Library::getAllObjects()
 {
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
     return allObjects;
 }
 
-StringArray Library::getAllCategories()
+StringArray Library::getAllCategories() const
 {
-    return allCategories;
+    return documentation->getCategories();
 }
 
 void Library::filesystemChanged()
@@ -283,6 +327,38 @@ void Library::filesystemChanged()
     updateLibrary();
 }
 
+void Library::fileChanged(File const file, FileSystemWatcher::FileSystemEvent event)
+{
+    if (!file.hasFileExtension("pd")) {
+        FileSystemWatcher::Listener::fileChanged(file, event);
+        return;
+    }
+
+    AbstractionCache::invalidate(file.getFullPathName());
+
+    // Changing the content of a patch doesn't change the list of objects
+    if (event == FileSystemWatcher::fileUpdated)
+        return;
+
+    // Added or removed patches only change the index of their directory, so we don't need to scan anything
+    objectSearchThread.addJob([this, file]() {
+        auto directory = file.getParentDirectory();
+        auto it = directoryIndex.find(directory.getFullPathName());
+        if (it == directoryIndex.end() || !it->second.scanned)
+            return;
+
+        auto& indexed = it->second;
+        auto const name = file.getFileNameWithoutExtension();
+        if (file.existsAsFile() && isPatchObject(file))
+            indexed.patches.addIfNotAlreadyThere(name);
+        else
+            indexed.patches.removeString(name);
+
+        indexed.modificationTime = directory.getLastModificationTime();
+        updateObjectList(false);
+    });
+}
+
 File Library::findHelpfile(t_gobj* obj, File const& parentPatchFile) const
 {
     String helpName;
@@ -7,8 +7,12 @@
 #pragma once
 
 #include <m_pd.h>
+#include <map>
+#include <set>
 #include "Utility/FileSystemWatcher.h"
 #include "Utility/Config.h"
+#include "ObjectSearchIndex.h"
+#include "ObjectDocumentation.h"
 
 namespace pd {
 
@@ -29,16 +33,17 @@ public:
     StringArray autocomplete(String const& query, File const& patchDirectory) const;
     void getExtraSuggestions(int currentNumSuggestions, String const& query, std::function<void(StringArray)> const& callback);
 
-    static std::array<StringArray, 2> parseIoletTooltips(ValueTree const& iolets, String const& name, int numIn, int numOut);
+    std::array<StringArray, 2> parseIoletTooltips(String const& objectType, String const& name, int numIn, int numOut) const;
 
     void filesystemChanged() override;
+    void fileChanged(File const file, FileSystemWatcher::FileSystemEvent event) override;
 
     File findHelpfile(t_gobj* obj, File const& parentPatchFile) const;
 
-    ValueTree getObjectInfo(String const& name);
+    ValueTree getObjectInfo(String const& name) const;
 
     StringArray getAllObjects();
-    StringArray getAllCategories();
+    StringArray getAllCategories() const;
 
     Array<File> helpPaths;
 
@@ -57,15 +62,37 @@ public:
     static inline StringArray objectOrigins = { "vanilla", "ELSE", "cyclone", "heavylib", "pdlua" };
 
 private:
+    struct IndexedDirectory {
+        bool scanned = false;
+        Time modificationTime;
+        StringArray patches;
+    };
+
+    void updateObjectList(bool rescan);
+    void addPatchesInDirectory(File const& directory, StringArray& objects, bool rescan, std::set<String>& visited);
+    static bool isPatchObject(File const& file);
+
     StringArray allObjects;
-    StringArray allCategories;
+
+    // Shared with all other instances, so the documentation is only read once per process
+    std::shared_ptr<ObjectDocumentation const> documentation;
+    ObjectSearchIndex searchIndex;
+
+    // Abstractions next to the patch that's being edited, only rescanned when the directory changes
+    mutable std::mutex patchDirectoryLock;
+    mutable File patchDirectory;
+    mutable Time patchDirectoryModificationTime;
+    mutable StringArray patchDirectoryObjects;
 
     std::recursive_mutex libraryLock;
 
+    // Only accessed from objectSearchThread
+    StringArray classNames;
+    Array<File> searchPaths;
+    std::map<String, IndexedDirectory> directoryIndex;
+
     FileSystemWatcher watcher;
     ThreadPool objectSearchThread = ThreadPool(1);
-
-    ValueTree documentationTree;
 };
 
 } // namespace pd
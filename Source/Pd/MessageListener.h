@@ -18,140 +18,303 @@ namespace pd {
 
 class MessageListener {
 public:
-    virtual void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) = 0;
+    // Messages aren't truncated, so numAtoms can be more than 8
+    virtual void receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms) = 0;
 
     JUCE_DECLARE_WEAK_REFERENCEABLE(MessageListener)
 };
 
+// Open addressing hash map with linear probing, for pointer-like keys
+// Memory is only allocated when the table grows, clearing it keeps the capacity so it can be reused without allocating
+template<typename Key, typename Value, typename Hash>
+class FlatHashMap {
+public:
+    Value* find(Key const& key)
+    {
+        if (numItems == 0)
+            return nullptr;
+
+        for (auto i = Hash()(key) & mask;; i = (i + 1) & mask) {
+            if (!slots[i].used)
+                return nullptr;
+            if (slots[i].key == key)
+                return &slots[i].value;
+        }
+    }
+
+    Value& operator[](Key const& key)
+    {
+        if ((numItems + 1) * 2 > slots.size())
+            grow();
+
+        auto i = Hash()(key) & mask;
+        for (; slots[i].used; i = (i + 1) & mask) {
+            if (slots[i].key == key)
+                return slots[i].value;
+        }
+
+        slots[i].used = true;
+        slots[i].key = key;
+        slots[i].value = Value();
+        numItems++;
+        return slots[i].value;
+    }
+
+    void erase(Key const& key)
+    {
+        if (numItems == 0)
+            return;
+
+        auto i = Hash()(key) & mask;
+        for (; slots[i].used; i = (i + 1) & mask) {
+            if (slots[i].key == key)
+                break;
+        }
+
+        if (!slots[i].used)
+            return;
+
+        // Shift back the entries that follow, so lookups never need tombstones
+        for (auto j = (i + 1) & mask; slots[j].used; j = (j + 1) & mask) {
+            auto const home = Hash()(slots[j].key) & mask;
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                slots[i] = std::move(slots[j]);
+                i = j;
+            }
+        }
+
+        slots[i].used = false;
+        slots[i].value = Value();
+        numItems--;
+    }
+
+    void clear()
+    {
+        for (auto& slot : slots) {
+            slot.used = false;
+        }
+        numItems = 0;
+    }
+
+    bool empty() const
+    {
+        return numItems == 0;
+    }
+
+private:
+    struct Slot {
+        Key key;
+        Value value;
+        bool used = false;
+    };
+
+    void grow()
+    {
+        auto oldSlots = std::move(slots);
+        slots = std::vector<Slot>(std::max<size_t>(16, oldSlots.size() * 2));
+        mask = slots.size() - 1;
+        numItems = 0;
+
+        for (auto& slot : oldSlots) {
+            if (slot.used)
+                (*this)[slot.key] = std::move(slot.value);
+        }
+    }
+
+    std::vector<Slot> slots;
+    size_t mask = 0;
+    size_t numItems = 0;
+};
+
 // MessageDispatcher handles the organising of messages from Pd to the plugdata GUI
-// It provides an optimised way to listen to messages within pd from the message thread,
-// without performing and memory allocation on the audio thread, and which groups messages within the same audio block (or multiple audio blocks, depending on how long it takes to get a callback from the message thread) togethter
-class MessageDispatcher : private AsyncUpdater {
-    // Wrapper to store 8 atoms in stack memory
-    // We never read more than 8 args in the whole source code, so this prevents unnecessary memory copying
-    // We also don't want this list to be dynamic since we want to stack allocate it
-    class Message {
-    public:
-        void* target;
-        t_symbol* symbol;
+// It provides an optimised way to listen to messages within pd from the message thread, without performing any memory allocation on the audio thread
+// Messages are delivered once per display frame, and only the last message for every target and selector within that frame is delivered
+class MessageDispatcher : private Timer {
+    // Messages are stored in the queue in chunks of 8 atoms, so the queue doesn't need to allocate
+    // Longer messages are followed by continuation chunks, which have no target
+    struct Message {
+        void* target = nullptr;
+        t_symbol* symbol = nullptr;
         t_atom data[8];
-        int size;
+        int size = 0; // Total number of atoms in the message, or in this chunk for continuations
+    };
 
-        Message() {};
+    struct MessageKey {
+        void* target = nullptr;
+        t_symbol* symbol = nullptr;
 
-        Message(void* ptr, t_symbol* sym, int argc, t_atom* argv)
-            : target(ptr)
-            , symbol(sym)
+        bool operator==(MessageKey const& other) const
         {
-            size = std::min(argc, 8);
-            std::copy(argv, argv + size, data);
+            return target == other.target && symbol == other.symbol;
         }
+    };
 
-        Message(Message const& other) noexcept
+    struct PointerHash {
+        size_t operator()(void* ptr) const
         {
-            target = other.target;
-            symbol = other.symbol;
-            size = other.size;
-            std::copy(other.data, other.data + other.size, data);
+            return static_cast<size_t>((reinterpret_cast<uint64>(ptr) >> 3) * 0x9E3779B97F4A7C15ull >> 16);
         }
 
-        Message& operator=(Message const& other) noexcept
+        size_t operator()(MessageKey const& key) const
         {
-            // Check for self-assignment
-            if (this != &other) {
-                target = other.target;
-                symbol = other.symbol;
-                size = other.size;
-                std::copy(other.data, other.data + other.size, data);
-            }
-
-            return *this;
+            return (*this)(key.target) ^ ((*this)(key.symbol) * 31);
         }
     };
 
+    // Coalesced message, with its atoms stored in atomBuffer
+    struct PendingMessage {
+        MessageKey key;
+        size_t atomOffset;
+        int numAtoms;
+    };
+
 public:
+    MessageDispatcher()
+    {
+        startTimerHz(60);
+    }
+
     void enqueueMessage(void* target, t_symbol* symbol, int argc, t_atom* argv)
     {
-        messageQueue.enqueue({ target, symbol, argc, argv });
+        Message message;
+        message.target = target;
+        message.symbol = symbol;
+        message.size = argc;
+        std::copy(argv, argv + std::min(argc, 8), message.data);
+        messageQueue.enqueue(message);
+
+        for (int offset = 8; offset < argc; offset += 8) {
+            Message continuation;
+            continuation.size = std::min(argc - offset, 8);
+            std::copy(argv + offset, argv + offset + continuation.size, continuation.data);
+            messageQueue.enqueue(continuation);
+        }
     }
 
     void addMessageListener(void* object, pd::MessageListener* messageListener)
     {
         ScopedLock lock(messageListenerLock);
-        messageListeners[object].insert(juce::WeakReference(messageListener));
+        auto& listeners = messageListeners[object];
+        if (std::find(listeners.begin(), listeners.end(), messageListener) == listeners.end())
+            listeners.emplace_back(messageListener);
     }
 
     void removeMessageListener(void* object, MessageListener* messageListener)
     {
         ScopedLock lock(messageListenerLock);
 
-        if (!messageListeners.count(object))
+        auto* listeners = messageListeners.find(object);
+        if (!listeners)
             return;
 
-        auto& listeners = messageListeners[object];
-        auto it = std::find(listeners.begin(), listeners.end(), messageListener);
-
-        if (it != listeners.end())
-            listeners.erase(it);
+        listeners->erase(std::remove(listeners->begin(), listeners->end(), messageListener), listeners->end());
 
-        if (listeners.empty())
+        if (listeners->empty())
             messageListeners.erase(object);
     }
 
-    void dispatch()
-    {
-        if (messageQueue.size_approx() != 0) {
-            triggerAsyncUpdate();
-        }
-    }
-
 private:
-    void handleAsyncUpdate() override
+    void timerCallback() override
     {
         Message incomingMessage;
-        std::map<size_t, Message> uniqueMessages;
-
         while (messageQueue.try_dequeue(incomingMessage)) {
-            auto hash = reinterpret_cast<size_t>(incomingMessage.target) ^ reinterpret_cast<size_t>(incomingMessage.symbol);
-            uniqueMessages[hash] = std::move(incomingMessage);
+            if (numReceivedAtoms < incompleteMessage.size) {
+                // Continuation of a long message
+                incompleteAtoms.insert(incompleteAtoms.end(), incomingMessage.data, incomingMessage.data + incomingMessage.size);
+                numReceivedAtoms += incomingMessage.size;
+
+                // The audio thread might still be enqueueing the rest, we'll pick that up on the next tick
+                if (numReceivedAtoms < incompleteMessage.size)
+                    continue;
+
+                addPendingMessage(incompleteMessage, incompleteAtoms.data());
+            } else if (incomingMessage.size > 8) {
+                incompleteMessage = incomingMessage;
+                incompleteAtoms.assign(incomingMessage.data, incomingMessage.data + 8);
+                numReceivedAtoms = 8;
+            } else {
+                addPendingMessage(incomingMessage, incomingMessage.data);
+            }
+        }
+
+        for (auto const& message : pendingMessages) {
+            deliverMessage(message);
         }
 
-        // Collect MessageListeners that have been deallocated for later removal
-        std::vector<std::pair<void*, std::set<juce::WeakReference<pd::MessageListener>>::iterator>> nullListeners;
+        pendingMessages.clear();
+        pendingIndices.clear();
+        atomBuffer.clear();
+    }
 
-        for (auto& [hash, message] : uniqueMessages) {
+    void addPendingMessage(Message const& message, t_atom const* messageAtoms)
+    {
+        auto const key = MessageKey { message.target, message.symbol };
 
-            if (messageListeners.find(message.target) == messageListeners.end())
-                continue;
+        // Store the atoms at the end of the buffer, the atoms of a message that gets replaced are simply left unused until the next frame
+        auto const atomOffset = atomBuffer.size();
+        atomBuffer.insert(atomBuffer.end(), messageAtoms, messageAtoms + message.size);
 
-            for (auto it = messageListeners.at(message.target).begin(); it != messageListeners.at(message.target).end(); ++it) {
-                if (it->wasObjectDeleted())
-                    continue;
+        auto& pendingIndex = pendingIndices[key];
+        if (pendingIndex == 0) {
+            pendingMessages.push_back({ key, atomOffset, message.size });
+            pendingIndex = static_cast<int>(pendingMessages.size()); // Offset by one, so zero means no message yet
+        } else {
+            auto& pendingMessage = pendingMessages[pendingIndex - 1];
+            pendingMessage.atomOffset = atomOffset;
+            pendingMessage.numAtoms = message.size;
+        }
+    }
 
-                auto listener = it->get();
+    void deliverMessage(PendingMessage const& message)
+    {
+        auto* listeners = messageListeners.find(message.key.target);
+        if (!listeners)
+            return;
 
-                pd::Atom atoms[8];
-                for (int at = 0; at < message.size; at++) {
-                    atoms[at] = pd::Atom(message.data + at);
-                }
-                auto symbol = message.symbol ? message.symbol : gensym(""); // TODO: fix instance issues!
+        atoms.resize(std::max<size_t>(atoms.size(), message.numAtoms));
+        for (int at = 0; at < message.numAtoms; at++) {
+            auto* atom = atomBuffer.data() + message.atomOffset + at;
+            atoms[at] = atom->a_type == A_SYMBOL ? pd::Atom(atom->a_w.w_symbol) : pd::Atom(atom->a_type == A_FLOAT ? atom->a_w.w_float : 0.0f);
+        }
+        auto symbol = message.key.symbol ? message.key.symbol : gensym(""); // TODO: fix instance issues!
 
-                if (listener)
-                    listener->receiveMessage(symbol, atoms, message.size);
-                else
-                    nullListeners.push_back({ message.target, it });
-            }
+        // Listeners may add or remove listeners while receiving a message, so work on a copy
+        currentListeners.assign(listeners->begin(), listeners->end());
+
+        bool hasDeletedListeners = false;
+        for (auto& listener : currentListeners) {
+            if (auto* messageListener = listener.get())
+                messageListener->receiveMessage(symbol, atoms.data(), message.numAtoms);
+            else
+                hasDeletedListeners = true;
         }
 
-        for (int i = nullListeners.size() - 1; i >= 0; i--) {
-            auto& [target, iterator] = nullListeners[i];
-            messageListeners[target].erase(iterator);
+        // Remove MessageListeners that have been deallocated
+        if (hasDeletedListeners) {
+            if (auto* targetListeners = messageListeners.find(message.key.target)) {
+                targetListeners->erase(std::remove_if(targetListeners->begin(), targetListeners->end(), [](auto const& listener) { return listener.wasObjectDeleted(); }), targetListeners->end());
+                if (targetListeners->empty())
+                    messageListeners.erase(message.key.target);
+            }
         }
     }
 
     moodycamel::ReaderWriterQueue<Message> messageQueue = moodycamel::ReaderWriterQueue<Message>(32768);
-    std::map<void*, std::set<juce::WeakReference<MessageListener>>> messageListeners;
+
+    FlatHashMap<void*, std::vector<juce::WeakReference<MessageListener>>, PointerHash> messageListeners;
     CriticalSection messageListenerLock;
+
+    // Reused for every frame, so dispatching doesn't allocate once they are large enough
+    FlatHashMap<MessageKey, int, PointerHash> pendingIndices;
+    std::vector<PendingMessage> pendingMessages;
+    std::vector<t_atom> atomBuffer;
+
+    // Long message that hasn't been fully dequeued yet
+    Message incompleteMessage;
+    std::vector<t_atom> incompleteAtoms;
+    int numReceivedAtoms = 0;
+    std::vector<pd::Atom> atoms;
+    std::vector<juce::WeakReference<MessageListener>> currentListeners;
 };
 
 }
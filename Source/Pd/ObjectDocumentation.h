@@ -0,0 +1,114 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <BinaryData.h>
+
+#include "ObjectSearchIndex.h"
+
+namespace pd {
+
+// The object documentation, read from binary data once and shared by every plugin instance in the process
+// Nothing in here is modified after it's built, so it can be read from any thread without locking
+class ObjectDocumentation {
+public:
+    struct Iolet {
+        String tooltip;
+        bool isVariable;
+    };
+
+    struct Entry {
+        ValueTree tree;
+        std::array<std::vector<Iolet>, 2> iolets; // inlets, outlets
+    };
+
+    // Stays alive for as long as anyone holds on to it, the next call after that will read it again
+    static std::shared_ptr<ObjectDocumentation const> getShared()
+    {
+        static std::mutex sharedLock;
+        static std::weak_ptr<ObjectDocumentation const> shared;
+
+        std::lock_guard<std::mutex> lock(sharedLock);
+        auto documentation = shared.lock();
+        if (!documentation) {
+            documentation = std::make_shared<ObjectDocumentation const>();
+            shared = documentation;
+        }
+
+        return documentation;
+    }
+
+    ObjectDocumentation()
+    {
+        MemoryInputStream instream(BinaryData::Documentation_bin, BinaryData::Documentation_binSize, false);
+        tree = ValueTree::readFromStream(instream);
+
+        for (auto object : tree) {
+            auto& entry = objects[object.getProperty("name").toString()];
+            entry.tree = object;
+
+            for (auto iolet : object.getChildWithName("iolets")) {
+                auto isVariable = iolet.getProperty("variable").toString() == "1";
+                auto tooltip = iolet.getProperty("tooltip").toString();
+                if (iolet.getType() == Identifier("inlet")) {
+                    entry.iolets[0].push_back({ tooltip, isVariable });
+                }
+                if (iolet.getType() == Identifier("outlet")) {
+                    entry.iolets[1].push_back({ tooltip, isVariable });
+                }
+            }
+
+            auto categoriesTree = object.getChildWithName("categories");
+            if (!categoriesTree.isValid())
+                continue;
+
+            for (auto category : categoriesTree) {
+                categories.addIfNotAlreadyThere(category.getProperty("name").toString());
+            }
+        }
+    }
+
+    Entry const* getEntry(String const& name) const
+    {
+        auto it = objects.find(name);
+        return it != objects.end() ? &it->second : nullptr;
+    }
+
+    ValueTree const& getTree() const
+    {
+        return tree;
+    }
+
+    StringArray const& getCategories() const
+    {
+        return categories;
+    }
+
+    // Tokenising all the documentation takes a while, so this is only done when the first search index asks for it
+    std::shared_ptr<ObjectSearchIndex::DocumentationWords const> getSearchWords() const
+    {
+        std::call_once(searchWordsFlag, [this]() {
+            searchWords = std::make_shared<ObjectSearchIndex::DocumentationWords const>(ObjectSearchIndex::buildDocumentationWords(tree));
+        });
+
+        return searchWords;
+    }
+
+private:
+    ValueTree tree;
+    std::unordered_map<String, Entry> objects;
+    StringArray categories;
+
+    mutable std::once_flag searchWordsFlag;
+    mutable std::shared_ptr<ObjectSearchIndex::DocumentationWords const> searchWords;
+};
+
+} // namespace pd
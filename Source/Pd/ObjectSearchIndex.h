@@ -0,0 +1,294 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace pd {
+
+// Search index over all object names and their documentation
+// Names are kept sorted for prefix lookups; words from names, descriptions, arguments and iolets go into an inverted index
+// The documentation part is built once, after that objects can be added and removed without rebuilding
+class ObjectSearchIndex {
+public:
+    // Weighted words for every documented object, these don't change so they can be shared between indices
+    using DocumentationWords = std::unordered_map<String, std::vector<std::pair<String, float>>>;
+
+    static DocumentationWords buildDocumentationWords(ValueTree const& documentation)
+    {
+        DocumentationWords newDocumentationWords;
+
+        for (auto object : documentation) {
+            std::unordered_map<String, float> weights;
+            auto addWords = [&weights](String const& text, float weight) {
+                for (auto const& word : tokenise(text)) {
+                    auto& existing = weights[word];
+                    existing = std::max(existing, weight);
+                }
+            };
+
+            addWords(object.getProperty("description").toString(), descriptionWeight);
+            for (auto argument : object.getChildWithName("arguments")) {
+                addWords(argument.getProperty("description").toString(), argumentWeight);
+            }
+            for (auto iolet : object.getChildWithName("iolets")) {
+                addWords(iolet.getProperty("description").toString(), argumentWeight);
+            }
+
+            auto& objectWords = newDocumentationWords[object.getProperty("name").toString()];
+            objectWords.assign(weights.begin(), weights.end());
+        }
+
+        return newDocumentationWords;
+    }
+
+    void setDocumentation(std::shared_ptr<DocumentationWords const> newDocumentationWords)
+    {
+        std::lock_guard<std::mutex> lock(indexLock);
+        documentationWords = std::move(newDocumentationWords);
+
+        // Objects might have been added before the documentation was ready
+        words.clear();
+        for (int id = 0; id < entries.size(); id++) {
+            addWordsForEntry(id);
+        }
+    }
+
+    // Only adds and removes the difference with the current set of objects
+    void setObjects(StringArray const& objects)
+    {
+        std::lock_guard<std::mutex> lock(indexLock);
+
+        std::unordered_map<String, bool> newObjects;
+        for (auto const& name : objects) {
+            newObjects[name] = true;
+        }
+
+        for (auto& entry : entries) {
+            if (entry.active && !newObjects.count(entry.name)) {
+                entry.active = false;
+                auto it = std::lower_bound(sortedNames.begin(), sortedNames.end(), entry.name);
+                if (it != sortedNames.end() && *it == entry.name)
+                    sortedNames.erase(it);
+            }
+        }
+
+        for (auto const& [name, unused] : newObjects) {
+            auto existing = ids.find(name);
+            if (existing != ids.end()) {
+                auto& entry = entries[existing->second];
+                if (entry.active)
+                    continue;
+                // Words for this entry are still in the index, so we only need to reactivate it
+                entry.active = true;
+            } else {
+                auto const id = static_cast<int>(entries.size());
+                entries.push_back({ name, true });
+                ids[name] = id;
+                addWordsForEntry(id);
+            }
+
+            sortedNames.insert(std::upper_bound(sortedNames.begin(), sortedNames.end(), name), name);
+        }
+    }
+
+    // Case-sensitive prefix search over object names, in alphabetical order
+    StringArray findByPrefix(String const& prefix, int maxResults) const
+    {
+        std::lock_guard<std::mutex> lock(indexLock);
+
+        StringArray result;
+        for (auto it = std::lower_bound(sortedNames.begin(), sortedNames.end(), prefix); it != sortedNames.end() && result.size() < maxResults; ++it) {
+            if (!it->startsWith(prefix))
+                break;
+
+            result.add(*it);
+        }
+
+        return result;
+    }
+
+    // Ranked search over names and documentation
+    // Every word in the query has to match a word of the object, either by prefix or with a single typo
+    StringArray search(String const& query, int maxResults) const
+    {
+        auto const queryWords = tokenise(query);
+        auto const trimmedQuery = query.trim();
+        if (trimmedQuery.isEmpty())
+            return {};
+
+        std::lock_guard<std::mutex> lock(indexLock);
+
+        std::unordered_map<int, std::pair<float, int>> scores; // score, number of matched query words
+
+        for (auto const& queryWord : queryWords) {
+            std::unordered_map<int, float> wordScores;
+            auto addPostings = [&wordScores](std::vector<Posting> const& postings, float multiplier) {
+                for (auto const& posting : postings) {
+                    auto& score = wordScores[posting.id];
+                    score = std::max(score, posting.weight * multiplier);
+                }
+            };
+
+            for (auto it = words.lower_bound(queryWord); it != words.end() && it->first.startsWith(queryWord); ++it) {
+                addPostings(it->second, it->first.length() == queryWord.length() ? 1.0f : 0.6f);
+            }
+
+            // Only look for typos if nothing matched exactly, it's the most expensive part of the search
+            if (wordScores.empty() && queryWord.length() >= 4) {
+                for (auto const& [word, postings] : words) {
+                    if (std::abs(word.length() - queryWord.length()) <= 1 && isSingleEdit(word, queryWord)) {
+                        addPostings(postings, 0.3f);
+                    }
+                }
+            }
+
+            for (auto const& [id, score] : wordScores) {
+                auto& total = scores[id];
+                total.first += score;
+                total.second++;
+            }
+        }
+
+        std::unordered_map<int, float> matches;
+        for (auto const& [id, score] : scores) {
+            if (entries[id].active && score.second == queryWords.size()) {
+                matches[id] = score.first;
+            }
+        }
+
+        // Also match names that contain the query anywhere, so symbols like "+~" can be found too
+        for (int id = 0; id < entries.size(); id++) {
+            auto const& entry = entries[id];
+            if (entry.active && entry.name.contains(trimmedQuery)) {
+                matches[id] += entry.name == trimmedQuery ? 10.0f : (entry.name.startsWith(trimmedQuery) ? 6.0f : 4.0f);
+            }
+        }
+
+        std::vector<std::pair<float, int>> ranked;
+        ranked.reserve(matches.size());
+        for (auto const& [id, score] : matches) {
+            ranked.emplace_back(score, id);
+        }
+
+        std::sort(ranked.begin(), ranked.end(), [this](auto const& a, auto const& b) {
+            if (a.first != b.first)
+                return a.first > b.first;
+            return entries[a.second].name < entries[b.second].name;
+        });
+
+        StringArray result;
+        for (int i = 0; i < std::min<int>(maxResults, ranked.size()); i++) {
+            result.add(entries[ranked[i].second].name);
+        }
+
+        return result;
+    }
+
+private:
+    struct Entry {
+        String name;
+        bool active;
+    };
+
+    struct Posting {
+        int id;
+        float weight;
+    };
+
+    static constexpr float nameWeight = 3.0f;
+    static constexpr float descriptionWeight = 2.0f;
+    static constexpr float argumentWeight = 1.0f;
+
+    // Splits text into lowercase words of at least two letters or digits
+    static StringArray tokenise(String const& text)
+    {
+        StringArray result;
+        String current;
+
+        for (auto c : text.toLowerCase()) {
+            if (CharacterFunctions::isLetterOrDigit(c)) {
+                current += c;
+            } else {
+                if (current.length() > 1)
+                    result.addIfNotAlreadyThere(current);
+                current.clear();
+            }
+        }
+
+        if (current.length() > 1)
+            result.addIfNotAlreadyThere(current);
+
+        return result;
+    }
+
+    // Checks if two words differ by at most one insertion, deletion or substitution
+    static bool isSingleEdit(String const& a, String const& b)
+    {
+        auto const* longer = a.length() >= b.length() ? &a : &b;
+        auto const* shorter = longer == &a ? &b : &a;
+
+        auto l = longer->getCharPointer();
+        auto s = shorter->getCharPointer();
+        bool const sameLength = longer->length() == shorter->length();
+        int edits = 0;
+
+        while (!l.isEmpty()) {
+            if (!s.isEmpty() && *l == *s) {
+                ++l;
+                ++s;
+                continue;
+            }
+
+            if (++edits > 1)
+                return false;
+
+            ++l;
+            if (sameLength && !s.isEmpty())
+                ++s;
+        }
+
+        return edits + static_cast<int>(s.length()) <= 1;
+    }
+
+    void addWordsForEntry(int id)
+    {
+        auto const& name = entries[id].name;
+
+        words[name.toLowerCase()].push_back({ id, nameWeight });
+        for (auto const& word : tokenise(name)) {
+            if (word != name.toLowerCase())
+                words[word].push_back({ id, nameWeight });
+        }
+
+        if (!documentationWords)
+            return;
+
+        auto documentation = documentationWords->find(name);
+        if (documentation == documentationWords->end())
+            return;
+
+        for (auto const& [word, weight] : documentation->second) {
+            words[word].push_back({ id, weight });
+        }
+    }
+
+    std::vector<Entry> entries;
+    std::unordered_map<String, int> ids;
+    std::vector<String> sortedNames;
+
+    // Ordered, so we can find all words that start with a query word
+    std::map<String, std::vector<Posting>> words;
+    std::shared_ptr<DocumentationWords const> documentationWords;
+
+    mutable std::mutex indexLock;
+};
+
+} // namespace pd
@@ -122,6 +122,11 @@ public:
     bool openInPluginMode = false;
     int splitViewIndex = 0;
 
+    // Content hash and compressed content of this patch in the last saved or restored plugin state
+    // Lets us skip compressing unchanged patches, and keep identical patches open when a state is restored
+    int64 stateHash = 0;
+    MemoryBlock stateData;
+
     String lastUndoSequence;
     String lastRedoSequence;
 
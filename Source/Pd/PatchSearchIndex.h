@@ -0,0 +1,431 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Interface.h"
+#include "Instance.h"
+#include "MessageListener.h"
+#include "Utility/FileSystemWatcher.h"
+
+namespace pd {
+
+// Lowercase words of the text, separated and surrounded by spaces, so a word can be found with a single contains() call
+// Whole words are kept next to their letter/digit parts, so both "osc~" and "osc" can be found
+inline String getSearchTokens(String const& text)
+{
+    StringArray tokens;
+    for (auto const& word : StringArray::fromTokens(text.toLowerCase(), true)) {
+        tokens.addIfNotAlreadyThere(word);
+
+        String current;
+        for (auto c : word) {
+            if (CharacterFunctions::isLetterOrDigit(c)) {
+                current += c;
+            } else {
+                if (current.isNotEmpty())
+                    tokens.addIfNotAlreadyThere(current);
+                current.clear();
+            }
+        }
+        if (current.isNotEmpty())
+            tokens.addIfNotAlreadyThere(current);
+    }
+
+    return " " + tokens.joinIntoString(" ") + " ";
+}
+
+// Every word in the query has to be the start of a word in the tokens
+inline bool matchesSearchTokens(String const& tokens, StringArray const& queryWords)
+{
+    for (auto const& word : queryWords) {
+        if (!tokens.contains(" " + word))
+            return false;
+    }
+    return !queryWords.isEmpty();
+}
+
+// Index of the objects in all open patches, used by the search panel
+// Every canvas is cached separately, and only read from pd again after it was invalidated, so searching through deeply nested abstractions doesn't need to walk through pd every time
+// Only used from the message thread
+class PatchSearchIndex {
+public:
+    struct Entry {
+        void* object;
+        String text;
+        String tokens;
+        int x, y;
+        t_canvas* subpatch; // nullptr if this isn't a subpatch or abstraction
+        bool isAbstraction;
+    };
+
+    explicit PatchSearchIndex(Instance* instance)
+        : pd(instance)
+    {
+    }
+
+    // Call this when objects in a canvas have been created, deleted, moved or renamed
+    // Canvases also invalidate themselves when pd tells them something changed, so dynamic patching is picked up without a canvas view
+    void invalidate(t_canvas* cnv)
+    {
+        auto it = canvases.find(cnv);
+        if (it != canvases.end())
+            it->second.dirty = true;
+    }
+
+    // Abstractions might have been replaced with new canvases, so nothing we have cached can be trusted anymore
+    void clear()
+    {
+        canvases.clear();
+    }
+
+    std::vector<Entry> const& getEntries(t_canvas* cnv)
+    {
+        auto it = canvases.find(cnv);
+        if (it == canvases.end())
+            it = canvases.try_emplace(cnv, WeakReference(cnv, pd), pd).first;
+
+        auto& indexed = it->second;
+        if (indexed.dirty)
+            update(indexed);
+
+        return indexed.entries;
+    }
+
+    // Forget about canvases that can't be reached from any of the open patches anymore
+    void removeUnusedCanvases(std::vector<t_canvas*> const& roots)
+    {
+        std::unordered_set<t_canvas*> reachable;
+        std::vector<t_canvas*> toVisit = roots;
+        while (!toVisit.empty()) {
+            auto* cnv = toVisit.back();
+            toVisit.pop_back();
+
+            if (!reachable.insert(cnv).second)
+                continue;
+
+            auto it = canvases.find(cnv);
+            if (it == canvases.end())
+                continue;
+
+            for (auto const& entry : it->second.entries) {
+                if (entry.subpatch)
+                    toVisit.push_back(entry.subpatch);
+            }
+        }
+
+        for (auto it = canvases.begin(); it != canvases.end();) {
+            if (!reachable.contains(it->first))
+                it = canvases.erase(it);
+            else
+                ++it;
+        }
+    }
+
+private:
+    struct IndexedCanvas : public MessageListener {
+        IndexedCanvas(WeakReference reference, Instance* instance)
+            : ref(std::move(reference))
+            , pd(instance)
+        {
+            pd->registerMessageListener(ref.getRawUnchecked<void>(), this);
+        }
+
+        ~IndexedCanvas()
+        {
+            pd->unregisterMessageListener(ref.getRawUnchecked<void>(), this);
+        }
+
+        // Pd sends messages to a canvas when objects in it are created, connected, cleared or changed, also when that's done by dynamic patching
+        void receiveMessage(t_symbol* symbol, pd::Atom const* atoms, int numAtoms) override
+        {
+            dirty = true;
+        }
+
+        WeakReference ref; // Makes sure we never read from a canvas that was freed while it was invalidated
+        Instance* pd;
+        std::vector<Entry> entries;
+        bool dirty = true;
+    };
+
+    void update(IndexedCanvas& indexed)
+    {
+        std::unordered_set<t_canvas*> oldSubpatches;
+        for (auto const& entry : indexed.entries) {
+            if (entry.subpatch)
+                oldSubpatches.insert(entry.subpatch);
+        }
+
+        indexed.entries.clear();
+        indexed.dirty = false;
+
+        auto cnv = indexed.ref.get<t_canvas>();
+        if (!cnv) {
+            for (auto* removed : oldSubpatches) {
+                removeRecursively(removed);
+            }
+            return;
+        }
+
+        for (auto* gobj = cnv->gl_list; gobj; gobj = gobj->g_next) {
+            auto* object = Interface::checkObject(gobj);
+            if (!object)
+                continue;
+
+            char* objectText;
+            int len;
+            Interface::getObjectText(object, &objectText, &len);
+            auto text = String::fromUTF8(objectText, len);
+            freebytes(static_cast<void*>(objectText), static_cast<size_t>(len) * sizeof(char));
+
+            int x, y, w, h;
+            Interface::getObjectBounds(cnv.get(), gobj, &x, &y, &w, &h);
+
+            auto* subpatch = pd_class(&gobj->g_pd) == canvas_class ? reinterpret_cast<t_canvas*>(gobj) : nullptr;
+            oldSubpatches.erase(subpatch);
+
+            indexed.entries.push_back({ gobj, text, getSearchTokens(text), x, y, subpatch, subpatch && canvas_isabstraction(subpatch) });
+        }
+
+        // Subpatches that were deleted might have their memory reused, so drop them and everything inside them
+        for (auto* removed : oldSubpatches) {
+            removeRecursively(removed);
+        }
+    }
+
+    void removeRecursively(t_canvas* cnv)
+    {
+        auto it = canvases.find(cnv);
+        if (it == canvases.end())
+            return;
+
+        auto entries = std::move(it->second.entries);
+        canvases.erase(it);
+
+        for (auto const& entry : entries) {
+            if (entry.subpatch)
+                removeRecursively(entry.subpatch);
+        }
+    }
+
+    Instance* pd;
+    std::unordered_map<t_canvas*, IndexedCanvas> canvases;
+};
+
+// Indexes the objects in patch files on disk, so the search panel can also find things in abstractions that aren't open
+// Files are only parsed again when their modification time changed
+// Directories are scanned again when the file system watcher sees a change, and every few seconds, because the watcher doesn't see subdirectories on Linux
+class PatchFileIndex : public Thread
+    , private FileSystemWatcher::Listener {
+public:
+    struct FileObject {
+        String text;
+        String tokens;
+        int x, y;
+    };
+
+    struct Result {
+        File file;
+        std::vector<FileObject> objects;
+    };
+
+    PatchFileIndex()
+        : Thread("Patch File Indexer")
+    {
+        watcher.addListener(this);
+    }
+
+    ~PatchFileIndex() override
+    {
+        watcher.removeListener(this);
+        stopThread(2000);
+    }
+
+    // Starts a new scan of these directories in the background
+    void setDirectories(Array<File> const& newDirectories)
+    {
+        {
+            std::lock_guard<std::mutex> lock(indexLock);
+            directories = newDirectories;
+        }
+
+        watcher.removeAllFolders();
+        for (auto const& directory : newDirectories) {
+            watcher.addFolder(directory);
+        }
+
+        if (!isThreadRunning())
+            startThread(Thread::Priority::background);
+
+        notify();
+    }
+
+    std::vector<Result> search(StringArray const& queryWords, StringArray const& excludedFiles, int maxResults) const
+    {
+        std::vector<Result> results;
+        if (queryWords.isEmpty())
+            return results;
+
+        std::lock_guard<std::mutex> lock(indexLock);
+
+        int numResults = 0;
+        for (auto const& [path, indexed] : files) {
+            if (excludedFiles.contains(path))
+                continue;
+
+            Result result { File(path), {} };
+            for (auto const& object : indexed.objects) {
+                if (numResults >= maxResults)
+                    break;
+
+                if (matchesSearchTokens(object.tokens, queryWords)) {
+                    result.objects.push_back(object);
+                    numResults++;
+                }
+            }
+
+            if (!result.objects.empty())
+                results.push_back(std::move(result));
+            if (numResults >= maxResults)
+                break;
+        }
+
+        return results;
+    }
+
+    std::function<void()> onIndexChanged = []() { };
+
+private:
+    struct IndexedFile {
+        Time modificationTime;
+        std::vector<FileObject> objects;
+    };
+
+    // Don't let a patch that lives in a huge directory make us index the entire disk
+    static constexpr int maxFiles = 4000;
+
+    // Files that didn't change are skipped, so a rescan only lists the directories
+    static constexpr int rescanInterval = 10000;
+
+    void filesystemChanged() override
+    {
+        notify();
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit()) {
+            Array<File> toScan;
+            {
+                std::lock_guard<std::mutex> lock(indexLock);
+                toScan = directories;
+            }
+
+            bool changed = false;
+            std::unordered_set<String> found;
+            for (auto const& directory : toScan) {
+                for (auto const& entry : RangedDirectoryIterator(directory, true, "*.pd", File::findFiles)) {
+                    if (threadShouldExit() || found.size() >= maxFiles)
+                        break;
+
+                    auto const& file = entry.getFile();
+                    auto path = file.getFullPathName();
+                    if (!found.insert(path).second)
+                        continue;
+
+                    {
+                        std::lock_guard<std::mutex> lock(indexLock);
+                        auto it = files.find(path);
+                        if (it != files.end() && it->second.modificationTime == entry.getModificationTime())
+                            continue;
+                    }
+
+                    IndexedFile indexed { entry.getModificationTime(), parsePatch(file.loadFileAsString()) };
+
+                    std::lock_guard<std::mutex> lock(indexLock);
+                    files[path] = std::move(indexed);
+                    changed = true;
+                }
+            }
+
+            if (threadShouldExit())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(indexLock);
+                for (auto it = files.begin(); it != files.end();) {
+                    if (!found.contains(it->first)) {
+                        it = files.erase(it);
+                        changed = true;
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+
+            if (changed) {
+                MessageManager::callAsync([_this = juce::WeakReference<PatchFileIndex>(this)]() {
+                    if (_this)
+                        _this->onIndexChanged();
+                });
+            }
+
+            wait(rescanInterval);
+        }
+    }
+
+    // Reads the objects, messages and comments from the content of a .pd file
+    static std::vector<FileObject> parsePatch(String const& content)
+    {
+        std::vector<FileObject> objects;
+
+        // Records end with an unescaped semicolon
+        String record;
+        for (auto const& line : StringArray::fromLines(content)) {
+            record += (record.isEmpty() ? "" : " ") + line;
+            if (!record.endsWithChar(';') || record.endsWith("\\;"))
+                continue;
+
+            auto tokens = StringArray::fromTokens(record.dropLastCharacters(1), " ", "");
+            tokens.removeEmptyStrings();
+            record.clear();
+
+            if (tokens.size() < 5 || tokens[0] != "#X")
+                continue;
+
+            auto const& type = tokens[1];
+            if (type != "obj" && type != "msg" && type != "text" && type != "restore")
+                continue;
+
+            auto x = tokens[2].getIntValue();
+            auto y = tokens[3].getIntValue();
+            tokens.removeRange(0, 4);
+
+            // Remove the object width
+            if (tokens.size() >= 2 && tokens[tokens.size() - 2] == "\\," && tokens[tokens.size() - 1].startsWith("f"))
+                tokens.removeRange(tokens.size() - 2, 2);
+
+            auto text = tokens.joinIntoString(" ").replace("\\,", ",").replace("\\;", ";").replace("\\$", "$");
+            objects.push_back({ text, getSearchTokens(text), x, y });
+        }
+
+        return objects;
+    }
+
+    Array<File> directories;
+    FileSystemWatcher watcher;
+    std::map<String, IndexedFile> files;
+    mutable std::mutex indexLock;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(PatchFileIndex)
+};
+
+} // namespace pd
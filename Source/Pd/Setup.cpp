@@ -6,13 +6,21 @@
 
 extern "C" {
 #include <m_pd.h>
+#include <m_imp.h>
 #include <z_hooks.h>
 #include <s_net.h>
 }
 
+#include <algorithm>
 #include <clocale>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 #include <string>
 #include <cstring>
+#include <unordered_map>
+#include <vector>
 #include "Setup.h"
 
 static t_class* plugdata_receiver_class;
@@ -159,6 +167,7 @@ static void plugdata_print(void* object, char const* message)
 extern "C" {
 
 void pd_init();
+void set_class_prefix(t_symbol*);
 
 // pd-extra objects functions declaration
 void bob_tilde_setup();
@@ -821,511 +830,788 @@ void Setup::parseArguments(char const** argv, size_t argc, t_namelist** sys_open
     return;
 }
 
-void Setup::initialiseELSE()
-{
-    knob_setup();
-    above_tilde_setup();
-    add_tilde_setup();
-    adsr_tilde_setup();
-    setup_allpass0x2e2nd_tilde();
-    setup_allpass0x2erev_tilde();
-    args_setup();
-    asr_tilde_setup();
-    autofade_tilde_setup();
-    autofade2_tilde_setup();
-    balance_tilde_setup();
-    bandpass_tilde_setup();
-    bandstop_tilde_setup();
-    setup_bend0x2ein();
-    setup_bend0x2eout();
-    setup_bl0x2esaw_tilde();
-    setup_bl0x2esaw2_tilde();
-    setup_bl0x2eimp_tilde();
-    setup_bl0x2eimp2_tilde();
-    setup_bl0x2esquare_tilde();
-    setup_bl0x2etri_tilde();
-    setup_bl0x2evsaw_tilde();
-    setup_osc0x2eformat();
-    setup_osc0x2eparse();
-    setup_osc0x2eroute();
-    beat_tilde_setup();
-    bicoeff_setup();
-    bicoeff2_setup();
-    bitnormal_tilde_setup();
-    biquads_tilde_setup();
-    blocksize_tilde_setup();
-    break_setup();
-    brown_tilde_setup();
-    buffer_setup();
-    button_setup();
-    setup_canvas0x2eactive();
-    setup_canvas0x2ebounds();
-    setup_canvas0x2eedit();
-    setup_canvas0x2egop();
-    setup_canvas0x2emouse();
-    setup_canvas0x2ename();
-    setup_canvas0x2epos();
-    setup_canvas0x2esetname();
-    setup_canvas0x2evis();
-    setup_canvas0x2ezoom();
-    setup_canvas0x2efile();
-    ceil_setup();
-    ceil_tilde_setup();
-    cents2ratio_setup();
-    cents2ratio_tilde_setup();
-    chance_setup();
-    chance_tilde_setup();
-    changed_setup();
-    changed_tilde_setup();
-    changed2_tilde_setup();
-    click_setup();
-    white_tilde_setup();
-    cmul_tilde_setup();
-    colors_setup();
-    setup_comb0x2efilt_tilde();
-    setup_comb0x2erev_tilde();
-    cosine_tilde_setup();
-    crackle_tilde_setup();
-    crossover_tilde_setup();
-    setup_ctl0x2ein();
-    setup_ctl0x2eout();
-    cusp_tilde_setup();
-    datetime_setup();
-    db2lin_tilde_setup();
-    decay_tilde_setup();
-    decay2_tilde_setup();
-    default_setup();
-    del_tilde_setup();
-    detect_tilde_setup();
-    dir_setup();
-    dollsym_setup();
-    downsample_tilde_setup();
-    drive_tilde_setup();
-    dust_tilde_setup();
-    dust2_tilde_setup();
-    else_setup();
-    envgen_tilde_setup();
-    eq_tilde_setup();
-    factor_setup();
-    fader_tilde_setup();
-    fbdelay_tilde_setup();
-    fbsine_tilde_setup();
-    fbsine2_tilde_setup();
-    setup_fdn0x2erev_tilde();
-    ffdelay_tilde_setup();
-    float2bits_setup();
-    floor_setup();
-    floor_tilde_setup();
-    fold_setup();
-    fold_tilde_setup();
-    fontsize_setup();
-    format_setup();
-    filterdelay_tilde_setup();
-    setup_freq0x2eshift_tilde();
-    function_setup();
-    function_tilde_setup();
-    gate2imp_tilde_setup();
-    gaussian_tilde_setup();
-    gbman_tilde_setup();
-    gcd_setup();
-    gendyn_tilde_setup();
-    setup_giga0x2erev_tilde();
-    glide_tilde_setup();
-    glide2_tilde_setup();
-    gray_tilde_setup();
-    henon_tilde_setup();
-    highpass_tilde_setup();
-    highshelf_tilde_setup();
-    hot_setup();
-    hz2rad_setup();
-    ikeda_tilde_setup();
-    imp_tilde_setup();
-    imp2_tilde_setup();
-    impseq_tilde_setup();
-    impulse_tilde_setup();
-    impulse2_tilde_setup();
-    initmess_setup();
-    keyboard_setup();
-    keycode_setup();
-    lag_tilde_setup();
-    lag2_tilde_setup();
-    lastvalue_tilde_setup();
-    latoocarfian_tilde_setup();
-    lb_setup();
-    lfnoise_tilde_setup();
-    limit_setup();
-    lincong_tilde_setup();
-    loadbanger_setup();
-    logistic_tilde_setup();
-    loop_setup();
-    lop2_tilde_setup();
-    lorenz_tilde_setup();
-    lowpass_tilde_setup();
-    lowshelf_tilde_setup();
-    match_tilde_setup();
-    median_tilde_setup();
-    merge_setup();
-    message_setup();
-    messbox_setup();
-    metronome_setup();
-    midi_setup();
-    mouse_setup();
-    setup_mov0x2eavg_tilde();
-    setup_mov0x2erms_tilde();
-    mtx_tilde_setup();
-    note_setup();
-    setup_note0x2ein();
-    setup_note0x2eout();
-    noteinfo_setup();
-    nyquist_tilde_setup();
-    op_tilde_setup();
-    openfile_setup();
-    oscope_tilde_setup();
-    pack2_setup();
-    pad_setup();
-    pan2_tilde_setup();
-    pan4_tilde_setup();
-    panic_setup();
-    parabolic_tilde_setup();
-    peak_tilde_setup();
-    setup_pgm0x2ein();
-    setup_pgm0x2eout();
-    pic_setup();
-    pimp_tilde_setup();
-    pink_tilde_setup();
-    pimpmul_tilde_setup();
-    plaits_tilde_setup();
-    pluck_tilde_setup();
-    power_tilde_setup();
-    properties_setup();
-    pulse_tilde_setup();
-    pulsecount_tilde_setup();
-    pulsediv_tilde_setup();
-    quad_tilde_setup();
-    quantizer_setup();
-    quantizer_tilde_setup();
-    rad2hz_setup();
-    ramp_tilde_setup();
-    rampnoise_tilde_setup();
-    setup_rand0x2ef();
-    setup_rand0x2eu();
-    setup_rand0x2ef_tilde();
-    setup_rand0x2ehist();
-    s2f_tilde_setup();
-    sfont_tilde_setup();
-    setup_rand0x2ei();
-    setup_rand0x2ei_tilde();
-    numbox_tilde_setup();
-    route2_setup();
-    randpulse_tilde_setup();
-    randpulse2_tilde_setup();
-    range_tilde_setup();
-    ratio2cents_setup();
-    ratio2cents_tilde_setup();
-    rec_setup();
-    receiver_setup();
-    rescale_setup();
-    rescale_tilde_setup();
-    resonant_tilde_setup();
-    resonant2_tilde_setup();
-    retrieve_setup();
-    rint_setup();
-    rint_tilde_setup();
-    rms_tilde_setup();
-    rotate_tilde_setup();
-    routeall_setup();
-    router_setup();
-    routetype_setup();
-    saw_tilde_setup();
-    saw2_tilde_setup();
-    schmitt_tilde_setup();
-    selector_setup();
-    separate_setup();
-    sequencer_tilde_setup();
-    sh_tilde_setup();
-    shaper_tilde_setup();
-    sig2float_tilde_setup();
-    sin_tilde_setup();
-    sine_tilde_setup();
-    slew_tilde_setup();
-    slew2_tilde_setup();
-    slice_setup();
-    sort_setup();
-    spread_setup();
-    spread_tilde_setup();
-    square_tilde_setup();
-    sr_tilde_setup();
-    standard_tilde_setup();
-    status_tilde_setup();
-    stepnoise_tilde_setup();
-    susloop_tilde_setup();
-    suspedal_setup();
-    svfilter_tilde_setup();
-    symbol2any_setup();
+// Setup functions of all ELSE and cyclone classes
+static void (*const elseSetupFunctions[])() = {
+    knob_setup,
+    above_tilde_setup,
+    add_tilde_setup,
+    adsr_tilde_setup,
+    setup_allpass0x2e2nd_tilde,
+    setup_allpass0x2erev_tilde,
+    args_setup,
+    asr_tilde_setup,
+    autofade_tilde_setup,
+    autofade2_tilde_setup,
+    balance_tilde_setup,
+    bandpass_tilde_setup,
+    bandstop_tilde_setup,
+    setup_bend0x2ein,
+    setup_bend0x2eout,
+    setup_bl0x2esaw_tilde,
+    setup_bl0x2esaw2_tilde,
+    setup_bl0x2eimp_tilde,
+    setup_bl0x2eimp2_tilde,
+    setup_bl0x2esquare_tilde,
+    setup_bl0x2etri_tilde,
+    setup_bl0x2evsaw_tilde,
+    setup_osc0x2eformat,
+    setup_osc0x2eparse,
+    setup_osc0x2eroute,
+    beat_tilde_setup,
+    bicoeff_setup,
+    bicoeff2_setup,
+    bitnormal_tilde_setup,
+    biquads_tilde_setup,
+    blocksize_tilde_setup,
+    break_setup,
+    brown_tilde_setup,
+    buffer_setup,
+    button_setup,
+    setup_canvas0x2eactive,
+    setup_canvas0x2ebounds,
+    setup_canvas0x2eedit,
+    setup_canvas0x2egop,
+    setup_canvas0x2emouse,
+    setup_canvas0x2ename,
+    setup_canvas0x2epos,
+    setup_canvas0x2esetname,
+    setup_canvas0x2evis,
+    setup_canvas0x2ezoom,
+    setup_canvas0x2efile,
+    ceil_setup,
+    ceil_tilde_setup,
+    cents2ratio_setup,
+    cents2ratio_tilde_setup,
+    chance_setup,
+    chance_tilde_setup,
+    changed_setup,
+    changed_tilde_setup,
+    changed2_tilde_setup,
+    click_setup,
+    white_tilde_setup,
+    cmul_tilde_setup,
+    colors_setup,
+    setup_comb0x2efilt_tilde,
+    setup_comb0x2erev_tilde,
+    cosine_tilde_setup,
+    crackle_tilde_setup,
+    crossover_tilde_setup,
+    setup_ctl0x2ein,
+    setup_ctl0x2eout,
+    cusp_tilde_setup,
+    datetime_setup,
+    db2lin_tilde_setup,
+    decay_tilde_setup,
+    decay2_tilde_setup,
+    default_setup,
+    del_tilde_setup,
+    detect_tilde_setup,
+    dir_setup,
+    dollsym_setup,
+    downsample_tilde_setup,
+    drive_tilde_setup,
+    dust_tilde_setup,
+    dust2_tilde_setup,
+    else_setup,
+    envgen_tilde_setup,
+    eq_tilde_setup,
+    factor_setup,
+    fader_tilde_setup,
+    fbdelay_tilde_setup,
+    fbsine_tilde_setup,
+    fbsine2_tilde_setup,
+    setup_fdn0x2erev_tilde,
+    ffdelay_tilde_setup,
+    float2bits_setup,
+    floor_setup,
+    floor_tilde_setup,
+    fold_setup,
+    fold_tilde_setup,
+    fontsize_setup,
+    format_setup,
+    filterdelay_tilde_setup,
+    setup_freq0x2eshift_tilde,
+    function_setup,
+    function_tilde_setup,
+    gate2imp_tilde_setup,
+    gaussian_tilde_setup,
+    gbman_tilde_setup,
+    gcd_setup,
+    gendyn_tilde_setup,
+    setup_giga0x2erev_tilde,
+    glide_tilde_setup,
+    glide2_tilde_setup,
+    gray_tilde_setup,
+    henon_tilde_setup,
+    highpass_tilde_setup,
+    highshelf_tilde_setup,
+    hot_setup,
+    hz2rad_setup,
+    ikeda_tilde_setup,
+    imp_tilde_setup,
+    imp2_tilde_setup,
+    impseq_tilde_setup,
+    impulse_tilde_setup,
+    impulse2_tilde_setup,
+    initmess_setup,
+    keyboard_setup,
+    keycode_setup,
+    lag_tilde_setup,
+    lag2_tilde_setup,
+    lastvalue_tilde_setup,
+    latoocarfian_tilde_setup,
+    lb_setup,
+    lfnoise_tilde_setup,
+    limit_setup,
+    lincong_tilde_setup,
+    loadbanger_setup,
+    logistic_tilde_setup,
+    loop_setup,
+    lop2_tilde_setup,
+    lorenz_tilde_setup,
+    lowpass_tilde_setup,
+    lowshelf_tilde_setup,
+    match_tilde_setup,
+    median_tilde_setup,
+    merge_setup,
+    message_setup,
+    messbox_setup,
+    metronome_setup,
+    midi_setup,
+    mouse_setup,
+    setup_mov0x2eavg_tilde,
+    setup_mov0x2erms_tilde,
+    mtx_tilde_setup,
+    note_setup,
+    setup_note0x2ein,
+    setup_note0x2eout,
+    noteinfo_setup,
+    nyquist_tilde_setup,
+    op_tilde_setup,
+    openfile_setup,
+    oscope_tilde_setup,
+    pack2_setup,
+    pad_setup,
+    pan2_tilde_setup,
+    pan4_tilde_setup,
+    panic_setup,
+    parabolic_tilde_setup,
+    peak_tilde_setup,
+    setup_pgm0x2ein,
+    setup_pgm0x2eout,
+    pic_setup,
+    pimp_tilde_setup,
+    pink_tilde_setup,
+    pimpmul_tilde_setup,
+    plaits_tilde_setup,
+    pluck_tilde_setup,
+    power_tilde_setup,
+    properties_setup,
+    pulse_tilde_setup,
+    pulsecount_tilde_setup,
+    pulsediv_tilde_setup,
+    quad_tilde_setup,
+    quantizer_setup,
+    quantizer_tilde_setup,
+    rad2hz_setup,
+    ramp_tilde_setup,
+    rampnoise_tilde_setup,
+    setup_rand0x2ef,
+    setup_rand0x2eu,
+    setup_rand0x2ef_tilde,
+    setup_rand0x2ehist,
+    s2f_tilde_setup,
+    sfont_tilde_setup,
+    setup_rand0x2ei,
+    setup_rand0x2ei_tilde,
+    numbox_tilde_setup,
+    route2_setup,
+    randpulse_tilde_setup,
+    randpulse2_tilde_setup,
+    range_tilde_setup,
+    ratio2cents_setup,
+    ratio2cents_tilde_setup,
+    rec_setup,
+    receiver_setup,
+    rescale_setup,
+    rescale_tilde_setup,
+    resonant_tilde_setup,
+    resonant2_tilde_setup,
+    retrieve_setup,
+    rint_setup,
+    rint_tilde_setup,
+    rms_tilde_setup,
+    rotate_tilde_setup,
+    routeall_setup,
+    router_setup,
+    routetype_setup,
+    saw_tilde_setup,
+    saw2_tilde_setup,
+    schmitt_tilde_setup,
+    selector_setup,
+    separate_setup,
+    sequencer_tilde_setup,
+    sh_tilde_setup,
+    shaper_tilde_setup,
+    sig2float_tilde_setup,
+    sin_tilde_setup,
+    sine_tilde_setup,
+    slew_tilde_setup,
+    slew2_tilde_setup,
+    slice_setup,
+    sort_setup,
+    spread_setup,
+    spread_tilde_setup,
+    square_tilde_setup,
+    sr_tilde_setup,
+    standard_tilde_setup,
+    status_tilde_setup,
+    stepnoise_tilde_setup,
+    susloop_tilde_setup,
+    suspedal_setup,
+    svfilter_tilde_setup,
+    symbol2any_setup,
     // table_tilde_setup();
-    tabplayer_tilde_setup();
-    tabreader_setup();
-    tabreader_tilde_setup();
-    tabwriter_tilde_setup();
-    tempo_tilde_setup();
-    setup_timed0x2egate_tilde();
-    toggleff_tilde_setup();
-    setup_touch0x2ein();
-    setup_touch0x2eout();
-    tri_tilde_setup();
-    setup_trig0x2edelay_tilde();
-    setup_trig0x2edelay2_tilde();
-    trighold_tilde_setup();
-    trunc_setup();
-    trunc_tilde_setup();
-    unmerge_setup();
-    voices_setup();
-    vsaw_tilde_setup();
-    vu_tilde_setup();
-    wt_tilde_setup();
-    wavetable_tilde_setup();
-    wrap2_setup();
-    wrap2_tilde_setup();
-    xfade_tilde_setup();
-    xgate_tilde_setup();
-    xgate2_tilde_setup();
-    xmod_tilde_setup();
-    xmod2_tilde_setup();
-    xselect_tilde_setup();
-    xselect2_tilde_setup();
-    zerocross_tilde_setup();
-    nchs_tilde_setup();
-    get_tilde_setup();
-    pick_tilde_setup();
-    sigs_tilde_setup();
-    select_tilde_setup();
-    setup_xselect0x2emc_tilde();
-    merge_tilde_setup();
-    unmerge_tilde_setup();
-    phaseseq_tilde_setup();
-    pol2car_tilde_setup();
-    car2pol_tilde_setup();
-    lin2db_tilde_setup();
-    sum_tilde_setup();
-    slice_tilde_setup();
-    order_setup();
-    repeat_tilde_setup();
-    setup_xgate0x2emc_tilde();
-    setup_xfade0x2emc_tilde();
+    tabplayer_tilde_setup,
+    tabreader_setup,
+    tabreader_tilde_setup,
+    tabwriter_tilde_setup,
+    tempo_tilde_setup,
+    setup_timed0x2egate_tilde,
+    toggleff_tilde_setup,
+    setup_touch0x2ein,
+    setup_touch0x2eout,
+    tri_tilde_setup,
+    setup_trig0x2edelay_tilde,
+    setup_trig0x2edelay2_tilde,
+    trighold_tilde_setup,
+    trunc_setup,
+    trunc_tilde_setup,
+    unmerge_setup,
+    voices_setup,
+    vsaw_tilde_setup,
+    vu_tilde_setup,
+    wt_tilde_setup,
+    wavetable_tilde_setup,
+    wrap2_setup,
+    wrap2_tilde_setup,
+    xfade_tilde_setup,
+    xgate_tilde_setup,
+    xgate2_tilde_setup,
+    xmod_tilde_setup,
+    xmod2_tilde_setup,
+    xselect_tilde_setup,
+    xselect2_tilde_setup,
+    zerocross_tilde_setup,
+    nchs_tilde_setup,
+    get_tilde_setup,
+    pick_tilde_setup,
+    sigs_tilde_setup,
+    select_tilde_setup,
+    setup_xselect0x2emc_tilde,
+    merge_tilde_setup,
+    unmerge_tilde_setup,
+    phaseseq_tilde_setup,
+    pol2car_tilde_setup,
+    car2pol_tilde_setup,
+    lin2db_tilde_setup,
+    sum_tilde_setup,
+    slice_tilde_setup,
+    order_setup,
+    repeat_tilde_setup,
+    setup_xgate0x2emc_tilde,
+    setup_xfade0x2emc_tilde,
 #ifdef ENABLE_SFIZZ
     // sfz_tilde_setup();
 #endif
-    sender_setup();
-    setup_ptouch0x2ein();
-    setup_ptouch0x2eout();
-    setup_spread0x2emc_tilde();
-    setup_rotate0x2emc_tilde();
-    pipe2_setup();
-    circuit_tilde_setup();
-
-    pm_tilde_setup();
-    pm2_tilde_setup();
-    pm4_tilde_setup();
-    pm6_tilde_setup();
-
-    var_setup();
-    conv_tilde_setup();
-    fm_tilde_setup();
+    sender_setup,
+    setup_ptouch0x2ein,
+    setup_ptouch0x2eout,
+    setup_spread0x2emc_tilde,
+    setup_rotate0x2emc_tilde,
+    pipe2_setup,
+    circuit_tilde_setup,
+
+    pm_tilde_setup,
+    pm2_tilde_setup,
+    pm4_tilde_setup,
+    pm6_tilde_setup,
+
+    var_setup,
+    conv_tilde_setup,
+    fm_tilde_setup,
+};
+
+static void (*const cycloneSetupFunctions[])() = {
+    cyclone_setup,
+    accum_setup,
+    acos_setup,
+    acosh_setup,
+    active_setup,
+    anal_setup,
+    append_setup,
+    asin_setup,
+    asinh_setup,
+    atanh_setup,
+    atodb_setup,
+    bangbang_setup,
+    bondo_setup,
+    borax_setup,
+    bucket_setup,
+    buddy_setup,
+    capture_setup,
+    cartopol_setup,
+    clip_setup,
+    coll_setup,
+    cosh_setup,
+    counter_setup,
+    cycle_setup,
+    dbtoa_setup,
+    decide_setup,
+    decode_setup,
+    drunk_setup,
+    flush_setup,
+    forward_setup,
+    fromsymbol_setup,
+    funnel_setup,
+    funbuff_setup,
+    gate_setup,
+    grab_setup,
+    histo_setup,
+    iter_setup,
+    join_setup,
+    linedrive_setup,
+    listfunnel_setup,
+    loadmess_setup,
+    match_setup,
+    maximum_setup,
+    mean_setup,
+    midiflush_setup,
+    midiformat_setup,
+    midiparse_setup,
+    minimum_setup,
+    mousefilter_setup,
+    mousestate_setup,
+    mtr_setup,
+    next_setup,
+    offer_setup,
+    onebang_setup,
+    pak_setup,
+    past_setup,
+    peak_setup,
+    poltocar_setup,
+    pong_setup,
+    prepend_setup,
+    prob_setup,
+    pv_setup,
+    rdiv_setup,
+    rminus_setup,
+    round_setup,
+    scale_setup,
+    seq_setup,
+    sinh_setup,
+    speedlim_setup,
+    spell_setup,
+    split_setup,
+    spray_setup,
+    sprintf_setup,
+    substitute_setup,
+    sustain_setup,
+    switch_setup,
+    table_setup,
+    tanh_setup,
+    thresh_setup,
+    togedge_setup,
+    tosymbol_setup,
+    trough_setup,
+    universal_setup,
+    unjoin_setup,
+    urn_setup,
+    uzi_setup,
+    xbendin_setup,
+    xbendin2_setup,
+    xbendout_setup,
+    xbendout2_setup,
+    xnotein_setup,
+    xnoteout_setup,
+    zl_setup,
+
+    acos_tilde_setup,
+    acosh_tilde_setup,
+    allpass_tilde_setup,
+    asin_tilde_setup,
+    asinh_tilde_setup,
+    atan_tilde_setup,
+    atan2_tilde_setup,
+    atanh_tilde_setup,
+    atodb_tilde_setup,
+    average_tilde_setup,
+    avg_tilde_setup,
+    bitand_tilde_setup,
+    bitnot_tilde_setup,
+    bitor_tilde_setup,
+    bitsafe_tilde_setup,
+    bitshift_tilde_setup,
+    bitxor_tilde_setup,
+    buffir_tilde_setup,
+    capture_tilde_setup,
+    cartopol_tilde_setup,
+    change_tilde_setup,
+    click_tilde_setup,
+    clip_tilde_setup,
+    comb_tilde_setup,
+    comment_setup,
+    cosh_tilde_setup,
+    cosx_tilde_setup,
+    count_tilde_setup,
+    cross_tilde_setup,
+    curve_tilde_setup,
+    cycle_tilde_setup,
+    dbtoa_tilde_setup,
+    degrade_tilde_setup,
+    delay_tilde_setup,
+    delta_tilde_setup,
+    deltaclip_tilde_setup,
+    downsamp_tilde_setup,
+    edge_tilde_setup,
+    equals_tilde_setup,
+    frameaccum_tilde_setup,
+    framedelta_tilde_setup,
+    gate_tilde_setup,
+    greaterthan_tilde_setup,
+    greaterthaneq_tilde_setup,
+    index_tilde_setup,
+    kink_tilde_setup,
+    lessthan_tilde_setup,
+    lessthaneq_tilde_setup,
+    line_tilde_setup,
+    lookup_tilde_setup,
+    lores_tilde_setup,
+    matrix_tilde_setup,
+    maximum_tilde_setup,
+    minimum_tilde_setup,
+    minmax_tilde_setup,
+    modulo_tilde_setup,
+    mstosamps_tilde_setup,
+    notequals_tilde_setup,
+    onepole_tilde_setup,
+    overdrive_tilde_setup,
+    peakamp_tilde_setup,
+    peek_tilde_setup,
+    phaseshift_tilde_setup,
+    phasewrap_tilde_setup,
+    play_tilde_setup,
+    plusequals_tilde_setup,
+    poke_tilde_setup,
+    poltocar_tilde_setup,
+    pong_tilde_setup,
+    pow_tilde_setup,
+    rampsmooth_tilde_setup,
+    rand_tilde_setup,
+    rdiv_tilde_setup,
+    record_tilde_setup,
+    reson_tilde_setup,
+    rminus_tilde_setup,
+    round_tilde_setup,
+    sah_tilde_setup,
+    sampstoms_tilde_setup,
+    scale_tilde_setup,
+    scope_tilde_setup,
+    selector_tilde_setup,
+    sinh_tilde_setup,
+    sinx_tilde_setup,
+    slide_tilde_setup,
+    snapshot_tilde_setup,
+    spike_tilde_setup,
+    svf_tilde_setup,
+    tanh_tilde_setup,
+    tanx_tilde_setup,
+    teeth_tilde_setup,
+    thresh_tilde_setup,
+    train_tilde_setup,
+    trapezoid_tilde_setup,
+    triangle_tilde_setup,
+    vectral_tilde_setup,
+    wave_tilde_setup,
+    zerox_tilde_setup,
+};
+
+struct LibrarySetup {
+    char const* prefix;
+    char const* externDir;
+    void (*librarySetup)(); // Sets up the library object itself, always done right away
+    void (*const* functions)();
+    int numFunctions;
+};
+
+static LibrarySetup const librarySetups[] = {
+    { "else", "9.else", else_setup, elseSetupFunctions, static_cast<int>(std::size(elseSetupFunctions)) },
+    { "cyclone", "10.cyclone", cyclone_setup, cycloneSetupFunctions, static_cast<int>(std::size(cycloneSetupFunctions)) }
+};
+
+// Setup functions that do more than registering classes: they bind global receivers or define GUI procedures
+// Patches can rely on those before any of their objects are created, so they are never set up lazily
+static void (*const eagerSetupFunctions[])() = {
+    setup_canvas0x2eactive,
+    setup_canvas0x2emouse,
+    click_setup,
+    colors_setup,
+    fontsize_setup,
+    keyboard_setup,
+    keycode_setup,
+    messbox_setup,
+    mouse_setup,
+    note_setup,
+    openfile_setup,
+    pic_setup,
+    properties_setup,
+    active_setup,
+    comment_setup,
+    mousefilter_setup,
+    mousestate_setup,
+};
+
+static bool isEagerSetup(int library, int function)
+{
+    auto const setup = librarySetups[library].functions[function];
+    return std::find(std::begin(eagerSetupFunctions), std::end(eagerSetupFunctions), setup) != std::end(eagerSetupFunctions);
+}
+
+// Which classes every setup function registers, and which setup functions have been called
+// Only accessed while holding the pd lock
+static std::vector<std::vector<bool>> librarySetupDone;
+static std::vector<std::vector<std::vector<std::string>>> librarySetupClasses;
+static std::unordered_map<std::string, std::pair<int, int>> lazyClasses;
+static std::string classTablePath;
+
+static void runLibrarySetup(int library, int function)
+{
+    if (librarySetupDone[library][function])
+        return;
+
+    librarySetupDone[library][function] = true;
+
+    auto const& setup = librarySetups[library];
+    set_class_prefix(gensym(setup.prefix));
+    class_set_extern_dir(gensym(setup.externDir));
+    setup.functions[function]();
+    class_set_extern_dir(gensym(""));
+    set_class_prefix(nullptr);
+}
+
+static void runAllLibrarySetups()
+{
+    for (int library = 0; library < std::size(librarySetups); library++) {
+        for (int function = 0; function < librarySetups[library].numFunctions; function++) {
+            runLibrarySetup(library, function);
+        }
+    }
+}
+
+static std::vector<std::string> getRegisteredClasses()
+{
+    std::vector<std::string> classes;
+
+    auto* mlist = static_cast<t_methodentry*>(libpd_get_class_methods(pd_objectmaker));
+    for (int i = 0; i < pd_objectmaker->c_nmethod; i++) {
+        if (mlist[i].me_name)
+            classes.emplace_back(mlist[i].me_name->s_name);
+    }
+
+    return classes;
+}
+
+static std::string getClassTableVersion(char const* version)
+{
+    return std::string("plugdata-class-table ") + version + " " + std::to_string(std::size(elseSetupFunctions)) + " " + std::to_string(std::size(cycloneSetupFunctions));
+}
+
+// Runs every setup function, and records which classes each one of them registers
+static void generateClassTable(char const* version)
+{
+    struct TableEntry {
+        int library, function;
+        bool eager;
+        std::vector<std::string> names;
+    };
+
+    // Classes that were there before we started can't be set up lazily, since they'd never be missing
+    std::unordered_map<std::string, int> registeredBy;
+    for (auto& name : getRegisteredClasses()) {
+        registeredBy[name] = -1;
+    }
+
+    std::vector<TableEntry> entries;
+    for (int library = 0; library < std::size(librarySetups); library++) {
+        for (int function = 0; function < librarySetups[library].numFunctions; function++) {
+            auto const numClasses = pd_objectmaker->c_nmethod;
+            runLibrarySetup(library, function);
+
+            auto const classes = getRegisteredClasses();
+            auto& entry = entries.emplace_back(TableEntry { library, function, isEagerSetup(library, function), {} });
+            auto const entryIndex = static_cast<int>(entries.size()) - 1;
+
+            for (int i = numClasses; i < classes.size(); i++) {
+                auto const& name = classes[i];
+                entry.names.push_back(name);
+
+                // When a class replaces another one, both have to be set up in the original order
+                auto [existing, inserted] = registeredBy.try_emplace(name, entryIndex);
+                if (!inserted || name.ends_with("_aliased")) {
+                    entry.eager = true;
+                    if (existing->second >= 0)
+                        entries[existing->second].eager = true;
+                }
+            }
+
+            // Setup functions that don't register a class might set up something the others need
+            entry.eager = entry.eager || entry.names.empty();
+        }
+    }
+
+    std::ofstream table(classTablePath, std::ios::trunc);
+    table << getClassTableVersion(version) << "\n";
+    for (auto const& entry : entries) {
+        table << entry.library << " " << entry.function << " " << entry.eager;
+        for (auto const& name : entry.names) {
+            table << " " << name;
+        }
+        table << "\n";
+    }
+
+    // Everything is set up already, but without a table the next start can't load the libraries lazily either
+    table.flush();
+    if (!table) {
+        std::remove(classTablePath.c_str());
+        pd_error(nullptr, "plugdata: couldn't write class table to %s, libraries can't be set up lazily", classTablePath.c_str());
+    }
+}
+
+static bool loadClassTable(char const* version)
+{
+    std::ifstream table(classTablePath);
+    std::string line;
+    if (!std::getline(table, line) || line != getClassTableVersion(version))
+        return false;
+
+    std::vector<std::pair<int, int>> eagerSetups;
+    while (std::getline(table, line)) {
+        std::istringstream entry(line);
+        int library, function, eager;
+        if (!(entry >> library >> function >> eager) || library < 0 || library >= std::size(librarySetups) || function < 0 || function >= librarySetups[library].numFunctions)
+            return false;
+
+        // Check the list as well, so a table that doesn't mark them can't make them lazy
+        if (eager || isEagerSetup(library, function)) {
+            eagerSetups.emplace_back(library, function);
+            continue;
+        }
+
+        std::string name;
+        while (entry >> name) {
+            librarySetupClasses[library][function].push_back(name);
+            lazyClasses[name] = { library, function };
+        }
+    }
+
+    for (auto [library, function] : eagerSetups) {
+        runLibrarySetup(library, function);
+    }
+
+    return true;
+}
+
+static t_anymethod defaultObjectMaker = nullptr;
+
+// Sets up the library functions that create this class, returns false if it's not a class we set up lazily
+static bool setupLazyClass(char const* classname)
+{
+    auto it = lazyClasses.find(classname);
+    if (it == lazyClasses.end())
+        return false;
+
+    auto const [library, function] = it->second;
+    if (librarySetupDone[library][function])
+        return false;
+
+    // Set up classes from the main instance, whenever a new instance is created the functions will be copied from there
+    auto* currentInstance = libpd_this_instance();
+    libpd_set_instance(libpd_get_instance(0));
+    runLibrarySetup(library, function);
+    libpd_set_instance(currentInstance);
+
+    // Our table doesn't match the library, fall back to setting up everything and generate a new table next time
+    if (!zgetfn(&pd_objectmaker, gensym(classname))) {
+        std::remove(classTablePath.c_str());
+        libpd_set_instance(libpd_get_instance(0));
+        runAllLibrarySetups();
+        libpd_set_instance(currentInstance);
+    }
+
+    return true;
 }
 
-void Setup::initialiseCyclone()
+// Pd calls this for every object name that isn't a known class, before it looks for externals and abstractions
+// Setting up our classes here means they take precedence over externals and abstractions with the same name, same as when they're set up right away
+static void lazyObjectMaker(t_pd* objectMaker, t_symbol* s, int argc, t_atom* argv)
 {
-    cyclone_setup();
-    accum_setup();
-    acos_setup();
-    acosh_setup();
-    active_setup();
-    anal_setup();
-    append_setup();
-    asin_setup();
-    asinh_setup();
-    atanh_setup();
-    atodb_setup();
-    bangbang_setup();
-    bondo_setup();
-    borax_setup();
-    bucket_setup();
-    buddy_setup();
-    capture_setup();
-    cartopol_setup();
-    clip_setup();
-    coll_setup();
-    cosh_setup();
-    counter_setup();
-    cycle_setup();
-    dbtoa_setup();
-    decide_setup();
-    decode_setup();
-    drunk_setup();
-    flush_setup();
-    forward_setup();
-    fromsymbol_setup();
-    funnel_setup();
-    funbuff_setup();
-    gate_setup();
-    grab_setup();
-    histo_setup();
-    iter_setup();
-    join_setup();
-    linedrive_setup();
-    listfunnel_setup();
-    loadmess_setup();
-    match_setup();
-    maximum_setup();
-    mean_setup();
-    midiflush_setup();
-    midiformat_setup();
-    midiparse_setup();
-    minimum_setup();
-    mousefilter_setup();
-    mousestate_setup();
-    mtr_setup();
-    next_setup();
-    offer_setup();
-    onebang_setup();
-    pak_setup();
-    past_setup();
-    peak_setup();
-    poltocar_setup();
-    pong_setup();
-    prepend_setup();
-    prob_setup();
-    pv_setup();
-    rdiv_setup();
-    rminus_setup();
-    round_setup();
-    scale_setup();
-    seq_setup();
-    sinh_setup();
-    speedlim_setup();
-    spell_setup();
-    split_setup();
-    spray_setup();
-    sprintf_setup();
-    substitute_setup();
-    sustain_setup();
-    switch_setup();
-    table_setup();
-    tanh_setup();
-    thresh_setup();
-    togedge_setup();
-    tosymbol_setup();
-    trough_setup();
-    universal_setup();
-    unjoin_setup();
-    urn_setup();
-    uzi_setup();
-    xbendin_setup();
-    xbendin2_setup();
-    xbendout_setup();
-    xbendout2_setup();
-    xnotein_setup();
-    xnoteout_setup();
-    zl_setup();
-
-    acos_tilde_setup();
-    acosh_tilde_setup();
-    allpass_tilde_setup();
-    asin_tilde_setup();
-    asinh_tilde_setup();
-    atan_tilde_setup();
-    atan2_tilde_setup();
-    atanh_tilde_setup();
-    atodb_tilde_setup();
-    average_tilde_setup();
-    avg_tilde_setup();
-    bitand_tilde_setup();
-    bitnot_tilde_setup();
-    bitor_tilde_setup();
-    bitsafe_tilde_setup();
-    bitshift_tilde_setup();
-    bitxor_tilde_setup();
-    buffir_tilde_setup();
-    capture_tilde_setup();
-    cartopol_tilde_setup();
-    change_tilde_setup();
-    click_tilde_setup();
-    clip_tilde_setup();
-    comb_tilde_setup();
-    comment_setup();
-    cosh_tilde_setup();
-    cosx_tilde_setup();
-    count_tilde_setup();
-    cross_tilde_setup();
-    curve_tilde_setup();
-    cycle_tilde_setup();
-    dbtoa_tilde_setup();
-    degrade_tilde_setup();
-    delay_tilde_setup();
-    delta_tilde_setup();
-    deltaclip_tilde_setup();
-    downsamp_tilde_setup();
-    edge_tilde_setup();
-    equals_tilde_setup();
-    frameaccum_tilde_setup();
-    framedelta_tilde_setup();
-    gate_tilde_setup();
-    greaterthan_tilde_setup();
-    greaterthaneq_tilde_setup();
-    index_tilde_setup();
-    kink_tilde_setup();
-    lessthan_tilde_setup();
-    lessthaneq_tilde_setup();
-    line_tilde_setup();
-    lookup_tilde_setup();
-    lores_tilde_setup();
-    matrix_tilde_setup();
-    maximum_tilde_setup();
-    minimum_tilde_setup();
-    minmax_tilde_setup();
-    modulo_tilde_setup();
-    mstosamps_tilde_setup();
-    notequals_tilde_setup();
-    onepole_tilde_setup();
-    overdrive_tilde_setup();
-    peakamp_tilde_setup();
-    peek_tilde_setup();
-    phaseshift_tilde_setup();
-    phasewrap_tilde_setup();
-    play_tilde_setup();
-    plusequals_tilde_setup();
-    poke_tilde_setup();
-    poltocar_tilde_setup();
-    pong_tilde_setup();
-    pow_tilde_setup();
-    rampsmooth_tilde_setup();
-    rand_tilde_setup();
-    rdiv_tilde_setup();
-    record_tilde_setup();
-    reson_tilde_setup();
-    rminus_tilde_setup();
-    round_tilde_setup();
-    sah_tilde_setup();
-    sampstoms_tilde_setup();
-    scale_tilde_setup();
-    scope_tilde_setup();
-    selector_tilde_setup();
-    sinh_tilde_setup();
-    sinx_tilde_setup();
-    slide_tilde_setup();
-    snapshot_tilde_setup();
-    spike_tilde_setup();
-    svf_tilde_setup();
-    tanh_tilde_setup();
-    tanx_tilde_setup();
-    teeth_tilde_setup();
-    thresh_tilde_setup();
-    train_tilde_setup();
-    trapezoid_tilde_setup();
-    triangle_tilde_setup();
-    vectral_tilde_setup();
-    wave_tilde_setup();
-    zerox_tilde_setup();
+    if (setupLazyClass(s->s_name)) {
+        typedmess(objectMaker, s, argc, argv);
+        return;
+    }
+
+    defaultObjectMaker(objectMaker, s, argc, argv);
+}
+
+void Setup::initialiseLibraries(char const* tablePath, char const* version, bool lazy)
+{
+    classTablePath = tablePath;
+
+    for (auto const& setup : librarySetups) {
+        librarySetupDone.emplace_back(setup.numFunctions, false);
+        librarySetupClasses.emplace_back(setup.numFunctions);
+    }
+
+    for (int library = 0; library < std::size(librarySetups); library++) {
+        auto const& setup = librarySetups[library];
+        auto const index = std::find(setup.functions, setup.functions + setup.numFunctions, setup.librarySetup) - setup.functions;
+        runLibrarySetup(library, static_cast<int>(index));
+    }
+
+    if (!lazy) {
+        runAllLibrarySetups();
+        return;
+    }
+
+    if (!loadClassTable(version)) {
+        lazyClasses.clear();
+        for (auto& classes : librarySetupClasses) {
+            for (auto& names : classes) {
+                names.clear();
+            }
+        }
+
+        generateClassTable(version);
+        return;
+    }
+
+    defaultObjectMaker = pd_objectmaker->c_anymethod;
+    class_addanything(pd_objectmaker, reinterpret_cast<t_method>(lazyObjectMaker));
+}
+
+std::vector<std::string> Setup::getLazyClassNames()
+{
+    std::vector<std::string> names;
+    for (int library = 0; library < librarySetupClasses.size(); library++) {
+        for (int function = 0; function < librarySetupClasses[library].size(); function++) {
+            if (!librarySetupDone[library][function]) {
+                auto const& classes = librarySetupClasses[library][function];
+                names.insert(names.end(), classes.begin(), classes.end());
+            }
+        }
+    }
+
+    return names;
 }
 
 }
@@ -11,6 +11,9 @@ extern "C" {
 #include <s_stuff.h>
 }
 
+#include <string>
+#include <vector>
+
 typedef void (*t_plugdata_banghook)(void* ptr, char const* recv);
 typedef void (*t_plugdata_floathook)(void* ptr, char const* recv, float f);
 typedef void (*t_plugdata_symbolhook)(void* ptr, char const* recv, char const* s);
@@ -33,8 +36,13 @@ struct Setup {
     void parseArguments(char const** args, size_t argc, t_namelist** sys_openlist, t_namelist** sys_messagelist);
 
     static void initialisePdLua(char const* datadir, char* vers, int vers_len, void(*register_class_callback)(const char*));
-    static void initialiseELSE();
-    static void initialiseCyclone();
+
+    // Sets up the ELSE and cyclone libraries. When lazy, classes are only set up the first time they are created
+    // That needs a table of which classes each setup function registers, which gets generated at tablePath on the first run
+    static void initialiseLibraries(char const* tablePath, char const* version, bool lazy);
+
+    // Classes that can be created, but haven't been set up yet
+    static std::vector<std::string> getLazyClassNames();
 
     static void* createMIDIHook(void* ptr,
         t_plugdata_noteonhook hook_noteon,
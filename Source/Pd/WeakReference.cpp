@@ -66,6 +66,11 @@ pd::WeakReference& pd::WeakReference::operator=(pd::WeakReference const& other)
     return *this;
 }
 
+pd::ReadHazards& pd::WeakReference::getReadHazards() const
+{
+    return pd->readHazards;
+}
+
 void pd::WeakReference::setThis() const
 {
     if (pd)
@@ -5,9 +5,11 @@
  */
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <unordered_map>
 #include <mutex>
+#include <thread>
 
 #include <m_pd.h>
 
@@ -15,6 +17,50 @@ using pd_weak_reference = std::atomic<bool>;
 
 namespace pd {
 
+// Number of pd locks held by the current thread, through WeakReference::Ptr or Instance::lockAudioThread
+// Direct messages sent while holding one are delivered right away, because the caller might read back what the message changed
+inline thread_local int threadLockDepth = 0;
+
+// Lets the GUI read from Pd objects without taking the audio lock
+// Every read publishes the object it's looking at in one of the slots of its instance, freeing a Pd object only waits while a read of that same object is in progress
+// Slots are claimed per read instead of per thread, so reads can be nested, and can look at different instances at the same time
+struct ReadHazards {
+    static constexpr int numSlots = 8;
+
+    // Returns the claimed slot, or nullptr if all slots are taken, in which case the read has to be skipped
+    std::atomic<void const*>* acquire(void const* object)
+    {
+        for (auto& slot : slots) {
+            void const* expected = nullptr;
+            if (slot.compare_exchange_strong(expected, object))
+                return &slot;
+        }
+
+        return nullptr;
+    }
+
+    static void release(std::atomic<void const*>* slot)
+    {
+        if (slot)
+            slot->store(nullptr);
+    }
+
+    // Waits until nobody is reading this object anymore
+    // Its weak references have already been invalidated at this point, so a read that starts now won't look at it, and the reads we wait for only copy a few fields
+    // This means the audio thread never waits for readers of other objects, or for readers that were preempted before or after their read
+    void synchronise(void const* object)
+    {
+        for (auto& slot : slots) {
+            while (slot.load() == object) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    std::atomic<void const*> slots[numSlots] = {};
+};
+
 class Instance;
 struct WeakReference {
     WeakReference(void* p, Instance* instance);
@@ -47,10 +93,12 @@ struct WeakReference {
             , ptr(pointer)
         {
             sys_lock();
+            threadLockDepth++;
         }
 
         ~Ptr()
         {
+            threadLockDepth--;
             sys_unlock();
         }
 
@@ -81,6 +129,51 @@ struct WeakReference {
         JUCE_DECLARE_NON_COPYABLE(Ptr)
     };
 
+    // Read-only access that doesn't lock the audio thread
+    // Only use this to poll plain fields: don't call into Pd and don't keep it around, since freeing this object will wait for it
+    // Evaluates to false when the object was freed, or when too many reads are in progress at once
+    template<typename T>
+    struct ReadPtr {
+
+        ReadPtr(T const* pointer, pd_weak_reference const& ref, ReadHazards& hazards)
+            : weakRef(ref)
+            , ptr(pointer)
+            , slot(pointer ? hazards.acquire(pointer) : nullptr)
+        {
+            // The object has to be published before checking the reference, so a free either sees us or we see that it was freed
+            if (slot && !weakRef) {
+                ReadHazards::release(slot);
+                slot = nullptr;
+            }
+        }
+
+        ~ReadPtr()
+        {
+            ReadHazards::release(slot);
+        }
+
+        operator bool() const
+        {
+            return slot != nullptr;
+        }
+
+        T const* get() const
+        {
+            return slot ? ptr : nullptr;
+        }
+
+        T const* operator->() const
+        {
+            return ptr;
+        }
+
+        pd_weak_reference const& weakRef;
+        T const* ptr;
+        std::atomic<void const*>* slot;
+
+        JUCE_DECLARE_NON_COPYABLE(ReadPtr)
+    };
+
     template<typename T>
     Ptr<T> get() const
     {
@@ -88,6 +181,12 @@ struct WeakReference {
         return Ptr<T>(reinterpret_cast<T*>(ptr), weakRef);
     }
 
+    template<typename T>
+    ReadPtr<T> peek() const
+    {
+        return ReadPtr<T>(reinterpret_cast<T const*>(ptr), weakRef, getReadHazards());
+    }
+
     template<typename T>
     T* getRaw() const
     {
@@ -101,12 +200,14 @@ struct WeakReference {
         return reinterpret_cast<T*>(ptr);
     }
 
-    bool isValid()
+    bool isValid() const
     {
         return weakRef && ptr != nullptr;
     }
 
 private:
+    ReadHazards& getReadHazards() const;
+
     void* ptr;
     Instance* pd;
     pd_weak_reference weakRef = true;
@@ -4,7 +4,9 @@
  // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
  */
 #include <clocale>
+#include <map>
 #include <memory>
+#include <thread>
 
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_basics/juce_audio_basics.h>
@@ -12,13 +14,15 @@
 
 #include "PluginProcessor.h"
 #include "Pd/Library.h"
+#include "Pd/AbstractionCache.h"
 
 #include "Utility/Config.h"
 #include "Utility/Fonts.h"
 #include "Utility/SettingsFile.h"
 #include "Utility/PluginParameter.h"
 #include "Utility/OSUtils.h"
-#include "Utility/AudioSampleRingBuffer.h"
+#include "Utility/BundledFilesystem.h"
+#include "Utility/AudioLevelMeter.h"
 #include "Utility/MidiDeviceManager.h"
 #include "Dialogs/ConnectionMessageDisplay.h"
 
@@ -127,9 +131,6 @@ PluginProcessor::PluginProcessor()
     midiBufferOut.ensureSize(2048);
     midiBufferInternalSynth.ensureSize(2048);
 
-    atoms_playhead.reserve(3);
-    atoms_playhead.resize(1);
-
     sendMessagesFromQueue();
 
     auto themeName = settingsFile->getProperty<String>("theme");
@@ -148,6 +149,7 @@ PluginProcessor::PluginProcessor()
 
     setProtectedMode(settingsFile->getProperty<int>("protected"));
     enableInternalSynth = settingsFile->getProperty<int>("internal_synth");
+    setConsoleRateLimit(settingsFile->getProperty<int>("console_rate_limit"));
 
     auto currentThemeTree = settingsFile->getCurrentTheme();
 
@@ -156,10 +158,32 @@ PluginProcessor::PluginProcessor()
     initialisePd(pdlua_version);
     logMessage(pdlua_version);
 
+    playheadReceiver = generateSymbol("_playhead");
+    playheadPositionReceiver = generateSymbol("playhead");
+
+    char const* playheadSelectorNames[NumPlayheadMessages] = { "playing", "recording", "looping", "edittime", "framerate", "bpm", "lastbar", "timesig", "position" };
+    for (int i = 0; i < NumPlayheadMessages; i++) {
+        playheadSelectors[i] = generateSymbol(playheadSelectorNames[i]);
+    }
+
+    // Now that pd is running, the parameters can resolve their receive symbols
+    for (auto* parameter : getParameters()) {
+        auto* pldParam = dynamic_cast<PlugDataParameter*>(parameter);
+        pldParam->setName(pldParam->getTitle());
+    }
+
     updateSearchPaths();
 
     objectLibrary = std::make_unique<pd::Library>(this);
 
+    // On first launch, the documentation is still being extracted, so read it again when that's done
+    if (BundledFilesystem::getInstance()->isExtracting()) {
+        BundledFilesystem::getInstance()->callWhenExtracted([_this = juce::WeakReference<pd::Instance>(this)]() {
+            if (auto* processor = dynamic_cast<PluginProcessor*>(_this.get()))
+                processor->objectLibrary->updateLibrary();
+        });
+    }
+
     setLatencySamples(pd::Instance::getBlockSize());
 }
 
@@ -177,36 +201,10 @@ void PluginProcessor::initialiseFilesystem()
     auto patches = homeDir.getChildFile("Patches");
 
     // Check if the abstractions directory exists, if not, unzip it from binaryData
-    if (!homeDir.exists() || !versionDataDir.exists()) {
-
-        // Binary data shouldn't be too big, then the compiler will run out of memory
-        // To prevent this, we split the binarydata into multiple files, and add them back together here
-        std::vector<char> allData;
-        int i = 0;
-        while (true) {
-            int size;
-            auto* resource = BinaryData::getNamedResource((String("Filesystem_") + String(i) + "_zip").toRawUTF8(), size);
-
-            if (!resource) {
-                break;
-            }
-
-            allData.insert(allData.end(), resource, resource + size);
-            i++;
-        }
-
-        MemoryInputStream memstream(allData.data(), allData.size(), false);
+    // Only the documentation is extracted in the background, so we don't keep the host waiting on first launch
+    auto* bundledFilesystem = BundledFilesystem::getInstance();
+    bundledFilesystem->initialise();
 
-        homeDir.createDirectory();
-
-        auto file = ZipFile(memstream);
-        file.uncompressTo(homeDir);
-
-        // Create filesystem for this specific version
-        versionDataDir.getParentDirectory().createDirectory();
-        versionDataDir.createDirectory();
-        homeDir.getChildFile("plugdata_version").moveFileTo(versionDataDir);
-    }
     if (!deken.exists()) {
         deken.createDirectory();
     }
@@ -214,16 +212,18 @@ void PluginProcessor::initialiseFilesystem()
         patches.createDirectory();
     }
 
-    auto testTonePatch = homeDir.getChildFile("testtone.pd");
-    auto cpuTestPatch = homeDir.getChildFile("load-meter.pd");
+    bundledFilesystem->callWhenExtracted([homeDir, versionDataDir]() {
+        auto testTonePatch = homeDir.getChildFile("testtone.pd");
+        auto cpuTestPatch = homeDir.getChildFile("load-meter.pd");
 
-    if (testTonePatch.exists())
-        testTonePatch.deleteFile();
-    if (cpuTestPatch.exists())
-        cpuTestPatch.deleteFile();
+        if (testTonePatch.exists())
+            testTonePatch.deleteFile();
+        if (cpuTestPatch.exists())
+            cpuTestPatch.deleteFile();
 
-    File(versionDataDir.getChildFile("./Documentation/7.stuff/tools/testtone.pd")).copyFileTo(testTonePatch);
-    File(versionDataDir.getChildFile("./Documentation/7.stuff/tools/load-meter.pd")).copyFileTo(cpuTestPatch);
+        File(versionDataDir.getChildFile("./Documentation/7.stuff/tools/testtone.pd")).copyFileTo(testTonePatch);
+        File(versionDataDir.getChildFile("./Documentation/7.stuff/tools/load-meter.pd")).copyFileTo(cpuTestPatch);
+    });
 
     // We want to recreate these symlinks so that they link to the abstractions/docs for the current plugdata version
     homeDir.getChildFile("Abstractions").deleteFile();
@@ -246,9 +246,12 @@ void PluginProcessor::initialiseFilesystem()
 
 #elif JUCE_IOS
     // This is not ideal but on iOS, it seems to be the only way to make it work...
+    // Abstractions and Extra are already extracted, and need to be there before any patch is loaded
     versionDataDir.getChildFile("Abstractions").copyDirectoryTo(homeDir.getChildFile("Abstractions"));
-    versionDataDir.getChildFile("Documentation").copyDirectoryTo(homeDir.getChildFile("Documentation"));
     versionDataDir.getChildFile("Extra").copyDirectoryTo(homeDir.getChildFile("Extra"));
+    bundledFilesystem->callWhenExtracted([homeDir, versionDataDir]() {
+        versionDataDir.getChildFile("Documentation").copyDirectoryTo(homeDir.getChildFile("Documentation"));
+    });
 #else
     versionDataDir.getChildFile("Abstractions").createSymbolicLink(homeDir.getChildFile("Abstractions"), true);
     versionDataDir.getChildFile("Documentation").createSymbolicLink(homeDir.getChildFile("Documentation"), true);
@@ -423,11 +426,16 @@ void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 
     audioAdvancement = 0;
     auto const pdBlockSize = static_cast<size_t>(Instance::getBlockSize());
-    audioBufferIn.setSize(maxChannels, pdBlockSize);
-    audioBufferOut.setSize(maxChannels, pdBlockSize);
 
-    audioVectorIn.resize(maxChannels * pdBlockSize, 0.0f);
-    audioVectorOut.resize(maxChannels * pdBlockSize, 0.0f);
+    // In the variable block size path, the FIFOs read into and write from Pd's own sound buffers, so there's nothing to copy around pd
+    auto referToSoundBuffers = [pdBlockSize](AudioBuffer<float>& audioBuffer, std::vector<float*> const& channels) {
+        if (channels.empty())
+            audioBuffer.setSize(0, static_cast<int>(pdBlockSize));
+        else
+            audioBuffer.setDataToReferTo(channels.data(), static_cast<int>(channels.size()), static_cast<int>(pdBlockSize));
+    };
+    referToSoundBuffers(audioBufferIn, getSoundInputs());
+    referToSoundBuffers(audioBufferOut, getSoundOutputs());
 
     midiBufferIn.clear();
     midiBufferOut.clear();
@@ -437,8 +445,8 @@ void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     variableBlockSize = !ProjectInfo::isStandalone || samplesPerBlock < pdBlockSize || samplesPerBlock % pdBlockSize != 0;
 
     if (variableBlockSize) {
-        inputFifo = std::make_unique<AudioMidiFifo>(maxChannels, std::max<int>(pdBlockSize, samplesPerBlock) * 3);
-        outputFifo = std::make_unique<AudioMidiFifo>(maxChannels, std::max<int>(pdBlockSize, samplesPerBlock) * 3);
+        inputFifo = std::make_unique<AudioMidiFifo>(audioBufferIn.getNumChannels(), std::max<int>(pdBlockSize, samplesPerBlock) * 3);
+        outputFifo = std::make_unique<AudioMidiFifo>(audioBufferOut.getNumChannels(), std::max<int>(pdBlockSize, samplesPerBlock) * 3);
     }
 
     midiByteIndex = 0;
@@ -521,6 +529,8 @@ void PluginProcessor::settingsFileReloaded()
         setTheme(newTheme);
     }
 
+    setConsoleRateLimit(settingsFile->getProperty<int>("console_rate_limit"));
+
     updateSearchPaths();
     if(objectLibrary) objectLibrary->updateLibrary();
 }
@@ -536,7 +546,6 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
 
     setThis();
     sendPlayhead();
-    sendParameters();
 
     for (int i = totalNumInputChannels; i < totalNumOutputChannels; ++i) {
         buffer.clear(i, 0, buffer.getNumSamples());
@@ -595,7 +604,7 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
 
     statusbarSource->process(hasMidiInEvents, hasMidiOutEvents, totalNumOutputChannels);
     statusbarSource->setCPUUsage(cpuLoadMeasurer.getLoadAsPercentage());
-    statusbarSource->peakBuffer.write(buffer);
+    statusbarSource->levelMeter.write(buffer);
 
     if (ProjectInfo::isStandalone) {
         for (auto bufferIterator : midiMessages) {
@@ -671,39 +680,41 @@ void PluginProcessor::processConstant(dsp::AudioBlock<float> buffer, MidiBuffer&
         midiBufferOut.clear();
     }
 
-    for (int block = 0; block < numBlocks; block++) {
-        for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
-            // Copy the channel data into the vector
-            juce::FloatVectorOperations::copy(
-                audioVectorIn.data() + (ch * blockSize),
-                buffer.getChannelPointer(ch) + audioAdvancement,
-                blockSize);
-        }
+    auto const& soundInputs = getSoundInputs();
+    auto const& soundOutputs = getSoundOutputs();
+    auto const numChannels = static_cast<int>(buffer.getNumChannels());
 
+    for (int block = 0; block < numBlocks; block++) {
         setThis();
 
         midiBufferIn.clear();
         midiBufferIn.addEvents(midiMessages, audioAdvancement, blockSize, 0);
         sendMidiBuffer();
 
-        // Process audio
-        performDSP(audioVectorIn.data(), audioVectorOut.data());
-
-        sendMessagesFromQueue();
+        // Checked per Pd block, so changes made from other threads while a large host buffer is processed land on the next block
+        // This isn't sample-accurate automation: the plugin wrappers only update host automation once per host buffer
+        sendParameters();
 
-        if (connectionListener && plugdata_debugging_enabled())
-            connectionListener->updateSignalData();
+        // The host buffer doesn't have Pd's layout, so this path copies once into Pd's sound buffers and once out of them
+        for (int ch = 0; ch < static_cast<int>(soundInputs.size()); ch++) {
+            if (ch < numChannels)
+                FloatVectorOperations::copy(soundInputs[ch], buffer.getChannelPointer(ch) + audioAdvancement, blockSize);
+            else
+                FloatVectorOperations::clear(soundInputs[ch], blockSize);
+        }
 
-        messageDispatcher->dispatch();
+        // Process audio
+        performDSP();
 
-        for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
-            // Use FloatVectorOperations to copy the vector data into the audioBuffer
-            juce::FloatVectorOperations::copy(
-                buffer.getChannelPointer(ch) + audioAdvancement,
-                audioVectorOut.data() + (ch * blockSize),
-                blockSize);
+        for (int ch = 0; ch < numChannels; ch++) {
+            if (ch < static_cast<int>(soundOutputs.size()))
+                FloatVectorOperations::copy(buffer.getChannelPointer(ch) + audioAdvancement, soundOutputs[ch], blockSize);
+            else
+                FloatVectorOperations::clear(buffer.getChannelPointer(ch) + audioAdvancement, blockSize);
         }
 
+        sendMessagesFromQueue();
+
         audioAdvancement += blockSize;
     }
 
@@ -714,9 +725,9 @@ void PluginProcessor::processConstant(dsp::AudioBlock<float> buffer, MidiBuffer&
 void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer& midiMessages)
 {
     auto const pdBlockSize = Instance::getBlockSize();
-    auto const numChannels = buffer.getNumChannels();
+    auto const numOutputs = static_cast<size_t>(audioBufferOut.getNumChannels());
 
-    inputFifo->writeAudioAndMidi(buffer, midiMessages);
+    inputFifo->writeAudioAndMidi(buffer.getSubsetChannelBlock(0, audioBufferIn.getNumChannels()), midiMessages);
     midiMessages.clear();
 
     audioAdvancement = 0; // Always has to be 0 if we use the AudioMidiFifo!
@@ -725,14 +736,6 @@ void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer&
         midiBufferIn.clear();
         inputFifo->readAudioAndMidi(audioBufferIn, midiBufferIn);
 
-        for (int channel = 0; channel < audioBufferIn.getNumChannels(); ++channel) {
-            // Copy the channel data into the vector
-            juce::FloatVectorOperations::copy(
-                audioVectorIn.data() + (channel * pdBlockSize),
-                audioBufferIn.getReadPointer(channel),
-                pdBlockSize);
-        }
-
         if (producesMidi()) {
             midiByteIndex = 0;
             midiByteBuffer[0] = 0;
@@ -745,23 +748,14 @@ void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer&
 
         sendMidiBuffer();
 
-        // Process audio
-        performDSP(audioVectorIn.data(), audioVectorOut.data());
-
-        sendMessagesFromQueue();
-
-        if (connectionListener && plugdata_debugging_enabled())
-            connectionListener->updateSignalData();
+        // Checked per Pd block, so changes made from other threads while a large host buffer is processed land on the next block
+        // This isn't sample-accurate automation: the plugin wrappers only update host automation once per host buffer
+        sendParameters();
 
-        messageDispatcher->dispatch();
+        // Process audio, audioBufferIn and audioBufferOut are Pd's own sound buffers
+        performDSP();
 
-        for (int channel = 0; channel < numChannels; ++channel) {
-            // Use FloatVectorOperations to copy the vector data into the audioBuffer
-            juce::FloatVectorOperations::copy(
-                audioBufferOut.getWritePointer(channel),
-                audioVectorOut.data() + (channel * pdBlockSize),
-                pdBlockSize);
-        }
+        sendMessagesFromQueue();
 
         outputFifo->writeAudioAndMidi(audioBufferOut, midiBufferOut);
     }
@@ -770,10 +764,52 @@ void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer&
     auto numAvailable = outputFifo->getNumSamplesAvailable();
     auto enough = std::max<int>((2 * pdBlockSize) - static_cast<int>(buffer.getNumSamples()), static_cast<int>(buffer.getNumSamples()));
     if (numAvailable >= enough) {
-        outputFifo->readAudioAndMidi(buffer, midiMessages);
+        auto outputBlock = buffer.getSubsetChannelBlock(0, numOutputs);
+        outputFifo->readAudioAndMidi(outputBlock, midiMessages);
+        if (buffer.getNumChannels() > numOutputs)
+            buffer.getSubsetChannelBlock(numOutputs, buffer.getNumChannels() - numOutputs).clear();
+    }
+}
+
+bool PluginProcessor::addSignalProbe(SignalProbe* probe)
+{
+    for (auto& slot : signalProbes) {
+        SignalProbe* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, probe))
+            return true;
+    }
+
+    return false;
+}
+
+void PluginProcessor::removeSignalProbe(SignalProbe* probe)
+{
+    for (auto& slot : signalProbes) {
+        SignalProbe* expected = probe;
+        slot.compare_exchange_strong(expected, nullptr);
+    }
+
+    // The audio thread marks itself busy before it loads the slots, so once it's not busy, it can't be holding on to this probe anymore
+    while (processingSignalProbes.load()) {
+        std::this_thread::yield();
     }
 }
 
+void PluginProcessor::receiveDSPTick()
+{
+    if (!plugdata_debugging_enabled())
+        return;
+
+    processingSignalProbes.store(true);
+    for (auto& slot : signalProbes) {
+        if (auto* probe = slot.load())
+            probe->process();
+    }
+    processingSignalProbes.store(false);
+}
+
+// Only sends the playhead messages that changed since they were last sent, and doesn't lock the audio thread if none did
+// Everything is sent again every second, so receivers that were created in the meantime get the current state
 void PluginProcessor::sendPlayhead()
 {
     AudioPlayHead* playhead = getPlayHead();
@@ -783,96 +819,125 @@ void PluginProcessor::sendPlayhead()
 
     auto infos = playhead->getPosition();
 
-    setThis();
-    if (infos.hasValue()) {
-        atoms_playhead[0] = static_cast<float>(infos->getIsPlaying());
-        sendMessage("_playhead", "playing", atoms_playhead);
+    if (!infos.hasValue())
+        return;
 
-        atoms_playhead[0] = static_cast<float>(infos->getIsRecording());
-        sendMessage("_playhead", "recording", atoms_playhead);
+    PlayheadValues values[NumPlayheadMessages];
+    auto setValues = [&values](PlayheadMessage type, std::initializer_list<float> newValues) {
+        auto& [valueArray, numValues] = values[type];
+        for (auto value : newValues)
+            valueArray[numValues++] = value;
+    };
 
-        atoms_playhead[0] = static_cast<float>(infos->getIsLooping());
+    setValues(PlayheadPlaying, { static_cast<float>(infos->getIsPlaying()) });
+    setValues(PlayheadRecording, { static_cast<float>(infos->getIsRecording()) });
 
-        auto loopPoints = infos->getLoopPoints();
-        if (loopPoints.hasValue()) {
-            atoms_playhead.emplace_back(static_cast<float>(loopPoints->ppqStart));
-            atoms_playhead.emplace_back(static_cast<float>(loopPoints->ppqEnd));
-        } else {
-            atoms_playhead.emplace_back(0.0f);
-            atoms_playhead.emplace_back(0.0f);
-        }
-        sendMessage("_playhead", "looping", atoms_playhead);
+    auto loopPoints = infos->getLoopPoints();
+    if (loopPoints.hasValue()) {
+        setValues(PlayheadLooping, { static_cast<float>(infos->getIsLooping()), static_cast<float>(loopPoints->ppqStart), static_cast<float>(loopPoints->ppqEnd) });
+    } else {
+        setValues(PlayheadLooping, { static_cast<float>(infos->getIsLooping()), 0.0f, 0.0f });
+    }
 
-        if (infos->getEditOriginTime().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getEditOriginTime());
-            sendMessage("_playhead", "edittime", atoms_playhead);
-        }
+    if (infos->getEditOriginTime().hasValue()) {
+        setValues(PlayheadEditTime, { static_cast<float>(*infos->getEditOriginTime()) });
+    }
 
-        if (infos->getFrameRate().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(infos->getFrameRate()->getEffectiveRate());
-            sendMessage("_playhead", "framerate", atoms_playhead);
-        }
+    if (infos->getFrameRate().hasValue()) {
+        setValues(PlayheadFrameRate, { static_cast<float>(infos->getFrameRate()->getEffectiveRate()) });
+    }
 
-        if (infos->getBpm().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getBpm());
-            sendMessage("_playhead", "bpm", atoms_playhead);
-        }
+    if (infos->getBpm().hasValue()) {
+        setValues(PlayheadBpm, { static_cast<float>(*infos->getBpm()) });
+    }
 
-        if (infos->getPpqPositionOfLastBarStart().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getPpqPositionOfLastBarStart());
-            sendMessage("_playhead", "lastbar", atoms_playhead);
-        }
+    if (infos->getPpqPositionOfLastBarStart().hasValue()) {
+        setValues(PlayheadLastBar, { static_cast<float>(*infos->getPpqPositionOfLastBarStart()) });
+    }
 
-        if (infos->getTimeSignature().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(infos->getTimeSignature()->numerator);
-            atoms_playhead.emplace_back(static_cast<float>(infos->getTimeSignature()->denominator));
-            sendMessage("_playhead", "timesig", atoms_playhead);
-        }
+    if (infos->getTimeSignature().hasValue()) {
+        setValues(PlayheadTimeSig, { static_cast<float>(infos->getTimeSignature()->numerator), static_cast<float>(infos->getTimeSignature()->denominator) });
+    }
 
-        if (infos->getPpqPosition().hasValue()) {
+    auto const ppq = infos->getPpqPosition().hasValue() ? static_cast<float>(*infos->getPpqPosition()) : 0.0f;
+    auto const samples = infos->getTimeInSamples().hasValue() ? static_cast<float>(*infos->getTimeInSamples()) : 0.0f;
+    auto const seconds = infos->getTimeInSeconds().hasValue() ? static_cast<float>(*infos->getTimeInSeconds()) : 0.0f;
 
-            atoms_playhead[0] = static_cast<float>(*infos->getPpqPosition());
-        } else {
-            atoms_playhead[0] = 0.0f;
-        }
+    setValues(PlayheadPosition, { ppq, samples, seconds });
 
-        if (infos->getTimeInSamples().hasValue()) {
-            atoms_playhead[1] = static_cast<float>(*infos->getTimeInSamples());
-        } else {
-            atoms_playhead[1] = 0.0f;
-        }
+    auto const now = Time::getMillisecondCounter();
+    auto const resendAll = now - lastPlayheadResendTime > 1000;
 
-        if (infos->getTimeInSeconds().hasValue()) {
-            atoms_playhead.emplace_back(static_cast<float>(*infos->getTimeInSeconds()));
-        } else {
-            atoms_playhead.emplace_back(0.0f);
+    bool changed[NumPlayheadMessages] = {};
+    bool anyChanged = false;
+    for (int i = 0; i < NumPlayheadMessages; i++) {
+        changed[i] = values[i].numValues > 0 && (resendAll || !(values[i] == lastPlayheadValues[i]));
+        anyChanged = anyChanged || changed[i];
+    }
+
+    if (!anyChanged)
+        return;
+
+    if (resendAll)
+        lastPlayheadResendTime = now;
+
+    setThis();
+
+    // Message thread edits can bind or unbind the receivers, so send everything under a single audio lock
+    lockAudioThread();
+
+    for (int i = 0; i < NumPlayheadMessages; i++) {
+        if (changed[i]) {
+            sendPlayheadMessage(static_cast<PlayheadMessage>(i), values[i]);
+            lastPlayheadValues[i] = values[i];
         }
+    }
+
+    unlockAudioThread();
+}
+
+void PluginProcessor::sendPlayheadMessage(PlayheadMessage type, PlayheadValues const& values)
+{
+    t_atom atoms[3];
+    for (int i = 0; i < values.numValues; i++) {
+        SETFLOAT(atoms + i, values.values[i]);
+    }
 
-        sendMessage("playhead", "position", atoms_playhead);
-        atoms_playhead.resize(1);
+    auto* receiver = type == PlayheadPosition ? playheadPositionReceiver : playheadReceiver;
+    if (receiver->s_thing) {
+        pd_typedmess(receiver->s_thing, playheadSelectors[type], values.numValues, atoms);
     }
 }
 
 void PluginProcessor::sendParameters()
 {
-    for (auto* param : getParameters()) {
+    auto const& parameters = getParameters();
+    bool isLocked = false;
+
+    for (int i = 0; i < parameters.size(); i++) {
         // We used to do dynamic_cast here, but since it gets called very often and param is always PlugDataParameter, we use reinterpret_cast now
-        auto* pldParam = reinterpret_cast<PlugDataParameter*>(param);
+        auto* pldParam = reinterpret_cast<PlugDataParameter*>(parameters.getUnchecked(i));
         if (!pldParam->isEnabled())
             continue;
 
         auto newvalue = pldParam->getUnscaledValue();
         if (!approximatelyEqual(pldParam->getLastValue(), newvalue)) {
-            auto title = pldParam->getTitle();
-            sendFloat(title.toRawUTF8(), pldParam->getUnscaledValue());
+            // Take the lock once for all changed parameters, instead of once per message
+            if (!isLocked) {
+                lockAudioThread();
+                isLocked = true;
+            }
+
+            auto* receiveSymbol = pldParam->getReceiveSymbol();
+            if (receiveSymbol && receiveSymbol->s_thing) {
+                pd_float(receiveSymbol->s_thing, newvalue);
+            }
             pldParam->setLastValue(newvalue);
         }
     }
+
+    if (isLocked)
+        unlockAudioThread();
 }
 
 void PluginProcessor::sendMidiBuffer()
@@ -953,53 +1018,47 @@ bool PluginProcessor::isInPluginMode()
     return false;
 }
 
+// The plugin state starts with the legacy layout: the number of patches, latency, oversampling, tail length and the settings xml
+// We write zero patches there, and store the compressed patches after the xml, starting with this magic number
+// Older versions stop reading after the xml, they restore the patches from the "Patches" element in the xml instead
+static constexpr int stateMagic = 0x54534450; // "PDST"
+static constexpr int stateVersion = 1;
+
 void PluginProcessor::getStateInformation(MemoryBlock& destData)
 {
     setThis();
 
     savePatchTabPositions();
 
-    // Store pure-data and parameter state
-    MemoryOutputStream ostream(destData, false);
-
-    ostream.writeInt(patches.size());
+    Array<pd::Patch::Ptr> statePatches;
+    statePatches.addArray(patches);
 
-    // Save path and content for patch
+    // Only hold the audio lock while saving the patches into binbufs, converting and compressing them happens after
+    std::vector<t_binbuf*> snapshots;
     lockAudioThread();
-
-    auto presetDir = ProjectInfo::appDataDir.getChildFile("Extra").getChildFile("Presets");
-
-    auto patchesTree = new XmlElement("Patches");
-
-    for (auto const& patch : patches) {
-
-        auto content = patch->getCanvasContent();
-        auto patchFile = patch->getCurrentFile().getFullPathName();
-
-        // Write legacy format
-        ostream.writeString(content);
-        ostream.writeString(patchFile);
-
-        auto* patchTree = new XmlElement("Patch");
-        // Write new format
-        patchTree->setAttribute("Content", content);
-        patchTree->setAttribute("Location", patchFile);
-        patchTree->setAttribute("PluginMode", patch->openInPluginMode);
-        patchTree->setAttribute("SplitIndex", patch->splitViewIndex);
-
-        patchesTree->addChildElement(patchTree);
+    for (auto const& patch : statePatches) {
+        auto cnv = patch->getPointer();
+        snapshots.push_back(cnv ? pd::Interface::getCanvasBinbuf(cnv.get()) : nullptr);
     }
     unlockAudioThread();
 
-    ostream.writeInt(getLatencySamples());
-    ostream.writeInt(oversampling);
-    ostream.writeFloat(getValue<float>(tailLength));
+    std::vector<String> contents;
+    for (auto* snapshot : snapshots) {
+        String content;
+        if (snapshot) {
+            char* buf;
+            int bufsize;
+            binbuf_gettext(snapshot, &buf, &bufsize);
+            binbuf_free(snapshot);
+
+            content = String::fromUTF8(buf, bufsize);
+            freebytes(static_cast<void*>(buf), static_cast<size_t>(bufsize) * sizeof(char));
+        }
+        contents.push_back(content);
+    }
 
     auto xml = XmlElement("plugdata_save");
     xml.setAttribute("Version", PLUGDATA_VERSION);
-
-    // In the future, we're gonna load everything from xml, to make it easier to add new properties
-    // By putting this here, we can prepare for making this change without breaking existing DAW saves
     xml.setAttribute("Oversampling", oversampling);
     xml.setAttribute("Latency", getLatencySamples());
     xml.setAttribute("TailLength", getValue<float>(tailLength));
@@ -1014,7 +1073,15 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
         xml.setAttribute("Height", lastUIHeight);
     }
 
-    xml.addChildElement(patchesTree);
+    // Uncompressed copy of the patches for older versions, newer versions read the compressed patches after the xml
+    auto* patchesTree = xml.createNewChildElement("Patches");
+    for (int i = 0; i < statePatches.size(); i++) {
+        auto* patchTree = patchesTree->createNewChildElement("Patch");
+        patchTree->setAttribute("Content", contents[i]);
+        patchTree->setAttribute("Location", statePatches[i]->getCurrentFile().getFullPathName());
+        patchTree->setAttribute("PluginMode", statePatches[i]->openInPluginMode);
+        patchTree->setAttribute("SplitIndex", statePatches[i]->splitViewIndex);
+    }
 
     PlugDataParameter::saveStateInformation(xml, getParameters());
 
@@ -1030,19 +1097,262 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
     MemoryBlock xmlBlock;
     copyXmlToBinary(xml, xmlBlock);
 
-    ostream.writeInt(static_cast<int>(xmlBlock.getSize()));
-    ostream.write(xmlBlock.getData(), xmlBlock.getSize());
-
     // then detach extraData XmlElement from temporary tree xml for later re-use
     if (extraDataStored) {
         xml.removeChildElement(extraData.get(), false);
     }
+
+    MemoryOutputStream ostream(destData, false);
+
+    // Legacy part, the patches are in the xml
+    ostream.writeInt(0);
+    ostream.writeInt(getLatencySamples());
+    ostream.writeInt(oversampling);
+    ostream.writeFloat(getValue<float>(tailLength));
+    ostream.writeInt(static_cast<int>(xmlBlock.getSize()));
+    ostream.write(xmlBlock.getData(), xmlBlock.getSize());
+
+    ostream.writeInt(stateMagic);
+    ostream.writeInt(stateVersion);
+    ostream.writeInt(statePatches.size());
+
+    // Hosts can save and restore the state from different threads at the same time, and both use the cached state of the patches
+    ScopedLock stateLock(patchStateLock);
+
+    for (int i = 0; i < statePatches.size(); i++) {
+        auto const& patch = statePatches[i];
+        auto const& content = contents[i];
+
+        // Only compress patches that changed since the last time we saved or restored them
+        auto const hash = content.hashCode64();
+        if (hash != patch->stateHash || patch->stateData.isEmpty()) {
+            patch->stateData.reset();
+            MemoryOutputStream compressed(patch->stateData, false);
+            GZIPCompressorOutputStream gzip(compressed);
+            gzip.write(content.toRawUTF8(), content.getNumBytesAsUTF8());
+            gzip.flush();
+            patch->stateHash = hash;
+        }
+
+        ostream.writeString(patch->getCurrentFile().getFullPathName());
+        ostream.writeBool(patch->openInPluginMode);
+        ostream.writeInt(patch->splitViewIndex);
+        ostream.writeInt64(patch->stateHash);
+        ostream.writeInt(static_cast<int>(patch->stateData.getSize()));
+        ostream.write(patch->stateData.getData(), patch->stateData.getSize());
+    }
+}
+
+// Returns true if the state has compressed patches after the legacy part
+static bool hasBinaryPatchState(void const* data, int sizeInBytes)
+{
+    MemoryInputStream istream(data, sizeInBytes, false);
+    if (istream.readInt() != 0)
+        return false;
+
+    istream.skipNextBytes(12); // latency, oversampling and tail length
+    istream.skipNextBytes(std::max(0, istream.readInt()));
+
+    return istream.getNumBytesRemaining() >= 8 && istream.readInt() == stateMagic;
+}
+
+void PluginProcessor::setBinaryStateInformation(void const* data, int sizeInBytes)
+{
+    MemoryInputStream istream(data, sizeInBytes, false);
+
+    // Legacy part, the settings are also in the xml
+    istream.readInt();
+    istream.skipNextBytes(12);
+
+    MemoryBlock xmlBlock;
+    istream.readIntoMemoryBlock(xmlBlock, std::max(0, istream.readInt()));
+    std::unique_ptr<XmlElement> xmlState(getXmlFromBinary(xmlBlock.getData(), static_cast<int>(xmlBlock.getSize())));
+
+    istream.readInt(); // magic number
+
+    if (istream.readInt() > stateVersion) {
+        logError("Can't load plugin state, it was saved by a newer version of plugdata");
+        return;
+    }
+
+    struct StatePatch {
+        String location;
+        bool pluginMode;
+        int splitIndex;
+        int64 hash;
+        MemoryBlock data;
+    };
+
+    // Read and decompress everything before touching any patches
+    // Every patch takes at least 18 bytes, so a corrupted count can't make us allocate more than the state could hold
+    auto const storedNumPatches = istream.readInt();
+    auto const numStatePatches = jlimit<int64>(0, istream.getNumBytesRemaining() / 18, storedNumPatches);
+    std::vector<StatePatch> statePatches(static_cast<size_t>(numStatePatches));
+    for (auto& statePatch : statePatches) {
+        statePatch.location = istream.readString();
+        statePatch.pluginMode = istream.readBool();
+        statePatch.splitIndex = istream.readInt();
+        statePatch.hash = istream.readInt64();
+        istream.readIntoMemoryBlock(statePatch.data, std::max(0, istream.readInt()));
+    }
+
+    setThis();
+
+    // Keep patches that are already open with the same location and content
+    Array<pd::Patch::Ptr> openPatches;
+    openPatches.addArray(patches);
+
+    std::vector<int64> openHashes;
+    for (auto const& patch : openPatches) {
+        openHashes.push_back(patch->getCanvasContent().hashCode64());
+    }
+
+    Array<pd::Patch::Ptr> reusedPatches;
+    for (auto const& statePatch : statePatches) {
+        pd::Patch::Ptr reused = nullptr;
+        for (int i = 0; i < openPatches.size(); i++) {
+            if (openPatches[i] && openHashes[i] == statePatch.hash && openPatches[i]->getCurrentFile().getFullPathName() == statePatch.location) {
+                reused = openPatches[i];
+                openPatches.set(i, nullptr);
+                break;
+            }
+        }
+        reusedPatches.add(reused);
+    }
+
+    patches.clear();
+    for (auto const& patch : reusedPatches) {
+        if (patch)
+            patches.add(patch);
+    }
+
+    // Close the tabs of patches that we didn't keep
+    if (getEditors().size()) {
+        MessageManager::callAsync([this]() {
+            for (auto* editor : getEditors()) {
+                for (int i = editor->canvases.size() - 1; i >= 0; i--) {
+                    auto* cnv = editor->canvases[i];
+                    auto* root = cnv->patch.getRoot();
+
+                    bool isKept = false;
+                    for (auto const& patch : patches) {
+                        isKept = isKept || patch->getPointer().get() == root;
+                    }
+
+                    if (!isKept)
+                        editor->closeTab(cnv);
+                }
+            }
+        });
+    }
+
+    // Reused patches were added first, so keep track of the order they were saved in
+    Array<pd::Patch::Ptr> orderedPatches;
+
+    auto presetDir = ProjectInfo::versionDataDir.getChildFile("Extra").getChildFile("Presets");
+    for (int i = 0; i < statePatches.size(); i++) {
+        auto& statePatch = statePatches[i];
+
+        if (auto& reused = reusedPatches.getReference(i)) {
+            reused->openInPluginMode = statePatch.pluginMode;
+            reused->splitViewIndex = statePatch.splitIndex;
+            orderedPatches.add(reused);
+            continue;
+        }
+
+        MemoryInputStream compressed(statePatch.data, false);
+        GZIPDecompressorInputStream gzip(compressed);
+        auto content = gzip.readEntireStreamAsString();
+
+        auto const numPatches = patches.size();
+        openPatchFromState(content, File(statePatch.location.replace("${PRESET_DIR}", presetDir.getFullPathName())), statePatch.pluginMode, statePatch.splitIndex);
+
+        if (patches.size() > numPatches) {
+            auto patch = patches[numPatches];
+            {
+                ScopedLock stateLock(patchStateLock);
+                patch->stateHash = statePatch.hash;
+                patch->stateData = std::move(statePatch.data);
+            }
+            orderedPatches.add(patch);
+        }
+    }
+
+    {
+        ScopedLock lock(patches.getLock());
+        patches.clear();
+        patches.addArray(orderedPatches);
+    }
+
+    // Kept tabs stay where they were and new ones are added at the end, so move them back into the saved order
+    // This is queued after the calls that add the tabs for the new patches
+    if (getEditors().size()) {
+        MessageManager::callAsync([this]() {
+            for (auto* editor : getEditors()) {
+                std::map<TabComponent*, int> nextTabIndex;
+                for (auto const& patch : patches) {
+                    for (auto* cnv : editor->canvases) {
+                        auto* tabbar = cnv->getTabbar();
+                        if (!tabbar || cnv->patch.getPointer().get() != patch->getPointer().get())
+                            continue;
+
+                        auto& targetIndex = nextTabIndex[tabbar];
+                        auto const currentIndex = cnv->getTabIndex();
+                        if (currentIndex >= 0 && currentIndex != targetIndex)
+                            tabbar->moveTab(currentIndex, targetIndex);
+                        targetIndex++;
+                    }
+                }
+            }
+        });
+    }
+
+    if (xmlState) {
+        PlugDataParameter::loadStateInformation(*xmlState, getParameters());
+
+        setOversampling(xmlState->getDoubleAttribute("Oversampling"));
+        setLatencySamples(xmlState->getDoubleAttribute("Latency"));
+        tailLength = xmlState->getDoubleAttribute("TailLength");
+
+        if (xmlState->hasAttribute("Height") && xmlState->hasAttribute("Width")) {
+            int windowWidth = xmlState->getIntAttribute("Width", 1000);
+            int windowHeight = xmlState->getIntAttribute("Height", 650);
+            lastUIWidth = windowWidth;
+            lastUIHeight = windowHeight;
+            // TODO: make multi-window friendly
+            if (auto* editor = getActiveEditor()) {
+                MessageManager::callAsync([editor = Component::SafePointer(editor), windowWidth, windowHeight]() {
+                    if (!editor)
+                        return;
+                    editor->setSize(windowWidth, windowHeight);
+                });
+            }
+        }
+
+        // Retrieve additional extra-data from DAW
+        parseDataBuffer(*xmlState);
+    }
+
+    MessageManager::callAsync([this]() {
+        for (auto* editor : getEditors()) {
+            editor->sidebar->updateAutomationParameters();
+
+            if (editor->pluginMode && !editor->pd->isInPluginMode()) {
+                editor->pluginMode->closePluginMode();
+            }
+        }
+    });
 }
 
 void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
 {
     if (sizeInBytes == 0)
         return;
+
+    if (hasBinaryPatchState(data, sizeInBytes)) {
+        setBinaryStateInformation(data, sizeInBytes);
+        return;
+    }
     
     // Don't clear tabs if there is no editor open before loading state, if we don't check this it will not load properly in some DAWs
     if(getEditors().size()) {
@@ -1088,32 +1398,6 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
 
     std::unique_ptr<XmlElement> xmlState(getXmlFromBinary(xmlData, xmlSize));
 
-    auto openPatch = [this](String const& content, File const& location, bool pluginMode = false, int splitIndex = 0) {
-        if (location.getFullPathName().isNotEmpty() && location.existsAsFile()) {
-            auto patch = loadPatch(location, getEditors()[0], splitIndex);
-            if (patch) {
-                patch->setTitle(location.getFileName());
-                patch->openInPluginMode = pluginMode;
-            }
-        } else {
-            if (location.getParentDirectory().exists()) {
-                auto parentPath = location.getParentDirectory().getFullPathName();
-                libpd_add_to_search_path(parentPath.toRawUTF8());
-            }
-            auto patch = loadPatch(content, getEditors()[0], splitIndex);
-            if (patch && ((location.exists() && location.getParentDirectory() == File::getSpecialLocation(File::tempDirectory)) || !location.exists())) {
-                patch->setTitle("Untitled Patcher");
-                patch->openInPluginMode = pluginMode;
-                patch->splitViewIndex = splitIndex;
-            } else if (patch && location.existsAsFile()) {
-                patch->setCurrentFile(location);
-                patch->setTitle(location.getFileName());
-                patch->openInPluginMode = pluginMode;
-                patch->splitViewIndex = splitIndex;
-            }
-        }
-    };
-
     if (xmlState) {
         // If xmltree contains new patch format, use that
         if (auto* patchTree = xmlState->getChildByName("Patches")) {
@@ -1130,13 +1414,13 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
                 auto presetDir = ProjectInfo::versionDataDir.getChildFile("Extra").getChildFile("Presets");
                 location = location.replace("${PRESET_DIR}", presetDir.getFullPathName());
 
-                openPatch(content, location, pluginMode, splitIndex);
+                openPatchFromState(content, location, pluginMode, splitIndex);
             }
         }
         // Otherwise, load from legacy format
         else {
             for (auto& [content, location] : patches) {
-                openPatch(content, location);
+                openPatchFromState(content, location, false, 0);
             }
         }
 
@@ -1194,6 +1478,33 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
     });
 }
 
+void PluginProcessor::openPatchFromState(String const& content, File const& location, bool pluginMode, int splitIndex)
+{
+    if (location.getFullPathName().isNotEmpty() && location.existsAsFile()) {
+        auto patch = loadPatch(location, getEditors()[0], splitIndex);
+        if (patch) {
+            patch->setTitle(location.getFileName());
+            patch->openInPluginMode = pluginMode;
+        }
+    } else {
+        if (location.getParentDirectory().exists()) {
+            auto parentPath = location.getParentDirectory().getFullPathName();
+            libpd_add_to_search_path(parentPath.toRawUTF8());
+        }
+        auto patch = loadPatch(content, getEditors()[0], splitIndex);
+        if (patch && ((location.exists() && location.getParentDirectory() == File::getSpecialLocation(File::tempDirectory)) || !location.exists())) {
+            patch->setTitle("Untitled Patcher");
+            patch->openInPluginMode = pluginMode;
+            patch->splitViewIndex = splitIndex;
+        } else if (patch && location.existsAsFile()) {
+            patch->setCurrentFile(location);
+            patch->setTitle(location.getFileName());
+            patch->openInPluginMode = pluginMode;
+            patch->splitViewIndex = splitIndex;
+        }
+    }
+}
+
 pd::Patch::Ptr PluginProcessor::loadPatch(File const& patchFile, PluginEditor* editor, int splitIndex)
 {
     // First, check if patch is already opened
@@ -1681,11 +1992,15 @@ void PluginProcessor::reloadAbstractions(File changedPatch, t_glist* except)
     setThis();
 
     // Ensure that all messages are dequeued before we start deleting objects
+    flushDirectMessages();
     sendMessagesFromQueue();
 
     isPerformingGlobalSync = true;
 
+    // The file might have been saved within the resolution of its modification time
+    pd::AbstractionCache::invalidate(changedPatch.getFullPathName());
     pd::Patch::reloadPatch(changedPatch, except);
+    patchSearchIndex.clear();
 
     for (auto* editor : getEditors()) {
 
@@ -16,6 +16,7 @@
 
 #include "Pd/Instance.h"
 #include "Pd/Patch.h"
+#include "Pd/PatchSearchIndex.h"
 
 namespace pd {
 class Library;
@@ -26,7 +27,7 @@ class SettingsFile;
 class StatusbarSource;
 struct PlugDataLook;
 class PluginEditor;
-class ConnectionMessageDisplay;
+class SignalProbe;
 class PluginProcessor : public AudioProcessor
     , public pd::Instance, public SettingsFileListener {
 public:
@@ -97,6 +98,8 @@ public:
     }
 
     void savePatchTabPositions();
+    void openPatchFromState(String const& content, File const& location, bool pluginMode, int splitIndex);
+    void setBinaryStateInformation(void const* data, int sizeInBytes);
     void updatePatchUndoRedoState();
         
     void settingsFileReloaded() override;
@@ -134,6 +137,9 @@ public:
     // All opened patches
     Array<pd::Patch::Ptr, CriticalSection> patches;
 
+    // Protects the cached state of the patches, which is used when saving and restoring the plugin state
+    CriticalSection patchStateLock;
+
     int lastUIWidth = 1000, lastUIHeight = 650;
 
     std::atomic<float>* volume;
@@ -142,6 +148,8 @@ public:
 
     std::unique_ptr<pd::Library> objectLibrary;
 
+    pd::PatchSearchIndex patchSearchIndex { this };
+
     File abstractions = ProjectInfo::versionDataDir.getChildFile("Abstractions");
 
     Value commandLocked = Value(var(false));
@@ -169,7 +177,10 @@ public:
     std::atomic<bool> enableInternalSynth = false;
 
     OwnedArray<PluginEditor> openedEditors;
-    Component::SafePointer<ConnectionMessageDisplay> connectionListener;
+
+    // Returns false if all probe slots are in use
+    bool addSignalProbe(SignalProbe* probe);
+    void removeSignalProbe(SignalProbe* probe);
 
 private:
     SmoothedValue<float, ValueSmoothingTypes::Linear> smoothedGain;
@@ -177,12 +188,11 @@ private:
     int audioAdvancement = 0;
 
     bool variableBlockSize = false;
+
+    // These refer to Pd's own sound buffers
     AudioBuffer<float> audioBufferIn;
     AudioBuffer<float> audioBufferOut;
 
-    std::vector<float> audioVectorIn;
-    std::vector<float> audioVectorOut;
-
     std::unique_ptr<AudioMidiFifo> inputFifo;
     std::unique_ptr<AudioMidiFifo> outputFifo;
 
@@ -192,11 +202,49 @@ private:
 
     AudioProcessLoadMeasurer cpuLoadMeasurer;
 
+    void receiveDSPTick() override;
+
+    // The audio thread goes over these without locking, removing a probe waits until it's done with them
+    std::array<std::atomic<SignalProbe*>, 8> signalProbes = {};
+    std::atomic<bool> processingSignalProbes = false;
+
     bool midiByteIsSysex = false;
     uint8 midiByteBuffer[512] = { 0 };
     size_t midiByteIndex = 0;
 
-    std::vector<pd::Atom> atoms_playhead;
+    enum PlayheadMessage {
+        PlayheadPlaying = 0,
+        PlayheadRecording,
+        PlayheadLooping,
+        PlayheadEditTime,
+        PlayheadFrameRate,
+        PlayheadBpm,
+        PlayheadLastBar,
+        PlayheadTimeSig,
+        PlayheadPosition,
+        NumPlayheadMessages
+    };
+
+    struct PlayheadValues {
+        float values[3] = {};
+        int numValues = 0;
+
+        bool operator==(PlayheadValues const& other) const
+        {
+            return numValues == other.numValues && std::equal(values, values + numValues, other.values);
+        }
+    };
+
+    void sendPlayheadMessage(PlayheadMessage type, PlayheadValues const& values);
+
+    // Playhead receivers and selectors are resolved once, instead of looking them up for every message
+    t_symbol* playheadReceiver = nullptr;
+    t_symbol* playheadPositionReceiver = nullptr;
+    t_symbol* playheadSelectors[NumPlayheadMessages] = { nullptr };
+
+    // Only accessed on the audio thread
+    PlayheadValues lastPlayheadValues[NumPlayheadMessages];
+    uint32 lastPlayheadResendTime = 0;
 
     int lastSetProgram = 0;
 
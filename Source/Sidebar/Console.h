@@ -142,139 +142,48 @@ public:
 
     void update()
     {
+        // Messages are laid out when the console becomes visible again
+        if (!isShowing())
+            return;
+
         console->update();
         resized();
         repaint();
     }
 
+    void visibilityChanged() override
+    {
+        update();
+    }
+
     void deselect()
     {
         console->selectedItems.clear();
         repaint();
     }
 
+    // Draws the console messages without a component per message, only the rows that are on screen get painted
+    // Rows are laid out incrementally when new messages arrive
     class ConsoleComponent : public Component {
-        class ConsoleMessage : public Component {
-
-            ConsoleComponent& console;
-
-        public:
-            int idx;
-
-            ConsoleMessage(int index, ConsoleComponent& parent)
-                : console(parent)
-                , idx(index)
-            {
-                parent.addAndMakeVisible(this);
-            }
-
-            void mouseDown(MouseEvent const& e)
-            {
-                if (!e.mods.isShiftDown() && !e.mods.isCommandDown()) {
-                    console.selectedItems.clear();
-                }
-
-                auto& [object, message, type, length, repeats] = console.pd->getConsoleMessages()[idx];
-                if (e.mods.isPopupMenu()) {
-                    
-                    
-                    PopupMenu menu;
-                    menu.addItem("Copy", [this]() { console.copySelectionToClipboard(); });
-                    menu.addItem("Show origin", object != nullptr, false, [this, target = object]() {
-                        auto* editor = findParentComponentOfClass<PluginEditor>();
-                        editor->highlightSearchTarget(target, true);
-                    });
-                    menu.showMenuAsync(PopupMenu::Options());
-                }
-
-                console.selectedItems.addIfNotAlreadyThere(SafePointer(this));
-                console.repaint();
-            }
-            
-            void paint(Graphics& g)
-            {
-                auto isSelected = console.selectedItems.contains(this);
-                auto showMessages = getValue<bool>(console.settingsValues[2]);
-                auto showErrors = getValue<bool>(console.settingsValues[3]);
-
-                if (isSelected) {
-                    // Draw selected background
-                    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-                    PlugDataLook::fillSmoothedRectangle(g, getLocalBounds().reduced(0, 1).toFloat().withTrimmedTop(0.5f), Corners::defaultCornerRadius);
-
-                    for (auto& item : console.selectedItems) {
-
-                        if (!item.getComponent())
-                            return;
-                        // Draw connected on top
-                        if (item->idx == idx - 1) {
-                            g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-                            g.fillRect(getLocalBounds().toFloat().withTrimmedBottom(5));
-
-                            g.setColour(findColour(PlugDataColour::outlineColourId));
-                            g.drawLine(10, 0, getWidth() - 10, 0);
-                        }
-
-                        // Draw connected on bottom
-                        if (item->idx == idx + 1) {
-                            g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-                            g.fillRect(getLocalBounds().toFloat().withTrimmedTop(5));
-                        }
-                    }
-                }
-
-                // Get console message
-                auto& [object, message, type, length, repeats] = console.pd->getConsoleMessages()[idx];
-
-                // Check if message type should be visible
-                if ((type == 0 && !showMessages) || (type == 1 && !showErrors)) {
-                    return;
-                }
-
-                // Approximate number of lines from string length and current width
-                auto totalLength = length + calculateRepeatOffset(repeats);
-                auto numLines = StringUtils::getNumLines(console.getWidth(), totalLength);
-
-                auto textColour = findColour(isSelected ? PlugDataColour::sidebarActiveTextColourId : PlugDataColour::sidebarTextColourId);
-
-                if (type == 1)
-                    textColour = Colours::orange;
-                else if (type == 2)
-                    textColour = Colours::red;
-
-                auto bounds = getLocalBounds().reduced(8, 2);
-                if (repeats > 1) {
-
-                    auto repeatIndicatorBounds = bounds.removeFromLeft(calculateRepeatOffset(repeats)).toFloat().translated(-4, 0.25);
-                    repeatIndicatorBounds = repeatIndicatorBounds.withSizeKeepingCentre(repeatIndicatorBounds.getWidth(), 21);
-
-                    auto circleColour = findColour(PlugDataColour::sidebarActiveBackgroundColourId);
-                    auto backgroundColour = findColour(PlugDataColour::sidebarBackgroundColourId);
-                    auto contrast = isSelected ? 1.5f : 0.5f;
-
-                    circleColour = Colour(circleColour.getRed() + (circleColour.getRed() - backgroundColour.getRed()) * contrast,
-                        circleColour.getGreen() + (circleColour.getGreen() - backgroundColour.getGreen()) * contrast,
-                        circleColour.getBlue() + (circleColour.getBlue() - backgroundColour.getBlue()) * contrast);
-
-                    g.setColour(circleColour);
-                    auto circleBounds = repeatIndicatorBounds.reduced(2);
-                    g.fillRoundedRectangle(circleBounds, circleBounds.getHeight() / 2.0f);
-
-                    Fonts::drawText(g, String(repeats), repeatIndicatorBounds, findColour(PlugDataColour::sidebarTextColourId), 12, Justification::centred);
-                }
-
-                // Draw text
-                Fonts::drawFittedText(g, message, bounds.translated(0, -1), textColour, numLines, 0.9f, 14);
-            }
+        struct Row {
+            int64 id;
+            int y;
+            int height;
         };
 
         std::array<Value, 5>& settingsValues;
         Viewport& viewport;
 
         pd::Instance* pd; // instance to get console messages from
+
+        std::deque<Row> rows;
+        int64 nextId = 0; // First message that hasn't been laid out yet
+        int layoutWidth = -1;
+        bool layoutShowsMessages = true;
+        bool layoutShowsErrors = true;
+
     public:
-        std::deque<std::unique_ptr<ConsoleMessage>> messages;
-        Array<SafePointer<ConsoleMessage>> selectedItems;
+        SortedSet<int64> selectedItems;
 
         ConsoleComponent(pd::Instance* instance, std::array<Value, 5>& b, Viewport& v)
             : settingsValues(b)
@@ -293,11 +202,13 @@ public:
 
         void copySelectionToClipboard()
         {
+            auto& consoleMessages = pd->getConsoleMessages();
+
             String textToCopy;
-            for (auto& item : selectedItems) {
-                if (!item.getComponent())
+            for (auto id : selectedItems) {
+                if (id < consoleMessages.getFirstVisibleId() || id >= consoleMessages.getEndId())
                     continue;
-                textToCopy += std::get<1>(pd->getConsoleMessages()[item->idx]) + "\n";
+                textToCopy += consoleMessages.get(id).text + "\n";
             }
 
             SystemClipboard::copyTextToClipboard(textToCopy.trimEnd());
@@ -316,60 +227,70 @@ public:
 
         void update()
         {
-            while (messages.size() > pd->getConsoleMessages().size() || messages.size() >= 800) {
-                messages.pop_front();
+            auto& consoleMessages = pd->getConsoleMessages();
+            auto const firstVisibleId = consoleMessages.getFirstVisibleId();
+            auto const showMessages = getValue<bool>(settingsValues[2]);
+            auto const showErrors = getValue<bool>(settingsValues[3]);
+
+            // Lay out everything again if the width or filters changed, or if cleared messages were restored
+            if (getWidth() != layoutWidth || showMessages != layoutShowsMessages || showErrors != layoutShowsErrors || (rows.empty() ? nextId : rows.front().id) > firstVisibleId) {
+                rows.clear();
+                nextId = firstVisibleId;
+                layoutWidth = getWidth();
+                layoutShowsMessages = showMessages;
+                layoutShowsErrors = showErrors;
+            }
 
-                // Make sure we don't trigger a repaint for all messages when the console is full
-                for (auto const& message : messages) {
-                    message->idx--;
-                }
+            // Forget rows for messages that were cleared or overwritten
+            while (!rows.empty() && rows.front().id < firstVisibleId) {
+                rows.pop_front();
             }
+            nextId = std::max(nextId, firstVisibleId);
 
-            while (messages.size() < pd->getConsoleMessages().size()) {
-                messages.push_back(std::make_unique<ConsoleMessage>(messages.size(), *this));
+            // The last message might have been repeated since we laid it out, which changes its size
+            if (!rows.empty() && rows.back().id == consoleMessages.getEndId() - 1) {
+                nextId = rows.back().id;
+                rows.pop_back();
+            }
+
+            for (; nextId < consoleMessages.getEndId(); nextId++) {
+                auto& message = consoleMessages.get(nextId);
+                if ((message.type == 0 && !showMessages) || (message.type == 1 && !showErrors))
+                    continue;
+
+                auto const y = rows.empty() ? 0 : rows.back().y + rows.back().height;
+                rows.push_back({ nextId, y, getRowHeight(message) });
             }
 
             setSize(getWidth(), std::max<int>(getTotalHeight(), viewport.getHeight()));
-            resized();
 
             if (getValue<bool>(settingsValues[4])) {
                 viewport.setViewPositionProportionately(0.0f, 1.0f);
             }
+
+            repaint();
         }
 
         void clear()
         {
-            pd->getConsoleHistory().insert(pd->getConsoleHistory().end(), pd->getConsoleMessages().begin(), pd->getConsoleMessages().end());
-            pd->getConsoleMessages().clear();
+            pd->getConsoleMessages().hideAll();
+            selectedItems.clear();
             update();
         }
 
         void restore()
         {
-            pd->getConsoleMessages().insert(pd->getConsoleMessages().begin(), pd->getConsoleHistory().begin(), pd->getConsoleHistory().end());
-            pd->getConsoleHistory().clear();
+            pd->getConsoleMessages().restore();
             update();
         }
 
         // Get total height of messages, also taking multi-line messages into account
-        int getTotalHeight()
+        int getTotalHeight() const
         {
-            auto showMessages = getValue<bool>(settingsValues[2]);
-            auto showErrors = getValue<bool>(settingsValues[3]);
-            auto totalHeight = 0;
-
-            for (auto& [object, message, type, length, repeats] : pd->getConsoleMessages()) {
-                auto totalLength = length + calculateRepeatOffset(repeats);
-                auto numLines = StringUtils::getNumLines(getWidth(), totalLength);
-                auto height = numLines * 13 + 12;
+            if (rows.empty())
+                return 8;
 
-                if ((type == 0 && !showMessages) || (type == 1 && !showErrors))
-                    continue;
-
-                totalHeight += std::max(0, height);
-            }
-
-            return totalHeight + 8;
+            return rows.back().y + rows.back().height - rows.front().y + 8;
         }
 
         static int calculateRepeatOffset(int numRepeats)
@@ -383,34 +304,135 @@ public:
 
         void mouseDown(MouseEvent const& e) override
         {
-            selectedItems.clear();
+            if (!e.mods.isShiftDown() && !e.mods.isCommandDown()) {
+                selectedItems.clear();
+            }
+
+            auto row = getFirstRowBelow(e.y);
+            if (row == rows.end() || !getRowBounds(*row).contains(e.getPosition())) {
+                repaint();
+                return;
+            }
+
+            auto const id = row->id;
+            if (e.mods.isPopupMenu()) {
+                auto* object = pd->getConsoleMessages().get(id).object;
+
+                PopupMenu menu;
+                menu.addItem("Copy", [this]() { copySelectionToClipboard(); });
+                menu.addItem("Show origin", object != nullptr, false, [this, target = object]() {
+                    auto* editor = findParentComponentOfClass<PluginEditor>();
+                    editor->highlightSearchTarget(target, true);
+                });
+                menu.showMenuAsync(PopupMenu::Options());
+            }
+
+            selectedItems.add(id);
             repaint();
         }
 
         void resized() override
         {
-            auto showMessages = getValue<bool>(settingsValues[2]);
-            auto showErrors = getValue<bool>(settingsValues[3]);
+            if (getWidth() != layoutWidth)
+                update();
+        }
 
-            int totalHeight = 4;
-            for (int row = 0; row < static_cast<int>(pd->getConsoleMessages().size()); row++) {
-                if (row >= messages.size())
-                    break;
+        void paint(Graphics& g) override
+        {
+            auto const clip = g.getClipBounds();
+            for (auto row = getFirstRowBelow(clip.getY()); row != rows.end() && getRowBounds(*row).getY() < clip.getBottom(); ++row) {
+                paintRow(g, row);
+            }
+        }
 
-                auto& [object, message, type, length, repeats] = pd->getConsoleMessages()[row];
+    private:
+        int getRowHeight(pd::ConsoleMessages::Message& message) const
+        {
+            // Approximate number of lines from string length and current width
+            auto totalLength = pd->getConsoleMessages().getWidth(message) + calculateRepeatOffset(message.repeats);
+            auto numLines = StringUtils::getNumLines(getWidth(), totalLength);
+            return numLines * 13 + 12;
+        }
 
-                auto totalLength = length + calculateRepeatOffset(repeats);
-                auto numLines = StringUtils::getNumLines(getWidth(), totalLength);
-                auto height = numLines * 13 + 12;
+        Rectangle<int> getRowBounds(Row const& row) const
+        {
+            int rightMargin = viewport.canScrollVertically() ? 13 : 11;
+            return { 6, row.y - rows.front().y + 4, getWidth() - rightMargin, row.height };
+        }
 
-                if ((type == 0 && !showMessages) || (type == 1 && !showErrors))
-                    continue;
+        // Finds the first row that ends below y
+        std::deque<Row>::iterator getFirstRowBelow(int y)
+        {
+            if (rows.empty())
+                return rows.end();
 
-                int rightMargin = viewport.canScrollVertically() ? 13 : 11;
-                messages[row]->setBounds(6, totalHeight, getWidth() - rightMargin, height);
+            auto const offset = rows.front().y - 4;
+            return std::upper_bound(rows.begin(), rows.end(), y + offset, [](int position, Row const& row) {
+                return position < row.y + row.height;
+            });
+        }
+
+        void paintRow(Graphics& g, std::deque<Row>::iterator row)
+        {
+            auto& message = pd->getConsoleMessages().get(row->id);
+            auto const rowBounds = getRowBounds(*row);
+            auto const isSelected = selectedItems.contains(row->id);
+
+            if (isSelected) {
+                // Draw selected background
+                g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+                PlugDataLook::fillSmoothedRectangle(g, rowBounds.reduced(0, 1).toFloat().withTrimmedTop(0.5f), Corners::defaultCornerRadius);
+
+                // Draw connected on top
+                if (row != rows.begin() && selectedItems.contains(std::prev(row)->id)) {
+                    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+                    g.fillRect(rowBounds.toFloat().withTrimmedBottom(5));
 
-                totalHeight += height;
+                    g.setColour(findColour(PlugDataColour::outlineColourId));
+                    g.drawLine(rowBounds.getX() + 10, rowBounds.getY(), rowBounds.getRight() - 10, rowBounds.getY());
+                }
+
+                // Draw connected on bottom
+                if (std::next(row) != rows.end() && selectedItems.contains(std::next(row)->id)) {
+                    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+                    g.fillRect(rowBounds.toFloat().withTrimmedTop(5));
+                }
             }
+
+            // Approximate number of lines from string length and current width
+            auto totalLength = pd->getConsoleMessages().getWidth(message) + calculateRepeatOffset(message.repeats);
+            auto numLines = StringUtils::getNumLines(getWidth(), totalLength);
+
+            auto textColour = findColour(isSelected ? PlugDataColour::sidebarActiveTextColourId : PlugDataColour::sidebarTextColourId);
+
+            if (message.type == 1)
+                textColour = Colours::orange;
+            else if (message.type == 2)
+                textColour = Colours::red;
+
+            auto bounds = rowBounds.reduced(8, 2);
+            if (message.repeats > 1) {
+
+                auto repeatIndicatorBounds = bounds.removeFromLeft(calculateRepeatOffset(message.repeats)).toFloat().translated(-4, 0.25);
+                repeatIndicatorBounds = repeatIndicatorBounds.withSizeKeepingCentre(repeatIndicatorBounds.getWidth(), 21);
+
+                auto circleColour = findColour(PlugDataColour::sidebarActiveBackgroundColourId);
+                auto backgroundColour = findColour(PlugDataColour::sidebarBackgroundColourId);
+                auto contrast = isSelected ? 1.5f : 0.5f;
+
+                circleColour = Colour(circleColour.getRed() + (circleColour.getRed() - backgroundColour.getRed()) * contrast,
+                    circleColour.getGreen() + (circleColour.getGreen() - backgroundColour.getGreen()) * contrast,
+                    circleColour.getBlue() + (circleColour.getBlue() - backgroundColour.getBlue()) * contrast);
+
+                g.setColour(circleColour);
+                auto circleBounds = repeatIndicatorBounds.reduced(2);
+                g.fillRoundedRectangle(circleBounds, circleBounds.getHeight() / 2.0f);
+
+                Fonts::drawText(g, String(message.repeats), repeatIndicatorBounds, findColour(PlugDataColour::sidebarTextColourId), 12, Justification::centred);
+            }
+
+            // Draw text
+            Fonts::drawFittedText(g, message.text, bounds.translated(0, -1), textColour, numLines, 0.9f, 14);
         }
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConsoleComponent)
@@ -6,6 +6,7 @@
 
 #include "Object.h"
 #include "Objects/ObjectBase.h"
+#include "Pd/PatchSearchIndex.h"
 #include <m_pd.h>
 #include <m_imp.h>
 
@@ -77,22 +78,41 @@ public:
         input.setTextToShowWhenEmpty("Type to search in patch", findColour(PlugDataColour::sidebarTextColourId).withAlpha(0.5f));
 
         input.onTextChange = [this]() {
-            patchTree.setFilterString(input.getText());
+            queryWords = StringArray::fromTokens(input.getText().toLowerCase(), true);
+            queryWords.removeEmptyStrings();
+            updateResults();
         };
 
         input.addKeyListener(this);
         patchTree.addKeyListener(this);
+
+        patchTree.matchesFilter = [this](ValueTree const& node, String const&) {
+            return pd::matchesSearchTokens(node.getProperty("Tokens").toString(), queryWords);
+        };
         
         patchTree.onClick = [this](ValueTree& tree){
+            if (tree.hasProperty("File")) {
+                editor->pd->loadPatch(File(tree.getProperty("File").toString()), editor);
+                return;
+            }
+
             auto* ptr = reinterpret_cast<void*>(static_cast<int64>(tree.getProperty("Object")));
             editor->highlightSearchTarget(ptr, true);
         };
         
         patchTree.onSelect = [this](ValueTree& tree){
+            if (!tree.hasProperty("TopLevel"))
+                return;
+
             auto* ptr = reinterpret_cast<void*>(static_cast<int64>(tree.getProperty("TopLevel")));
             editor->highlightSearchTarget(ptr, false);
         };
 
+        fileIndex.onIndexChanged = [this]() {
+            if (!queryWords.isEmpty())
+                updateResults();
+        };
+
         addAndMakeVisible(patchTree);
         addAndMakeVisible(input);
 
@@ -182,12 +202,41 @@ public:
     void updateResults()
     {
         auto* cnv = editor->getCurrentCanvas();
-        if(cnv) {
-            cnv->pd->lockAudioThread(); // It locks inside of this anyway, so we might as well lock around it to prevent constantly locking/unlocking
-            auto tree = generatePatchTree(cnv->refCountedPatch);
-            patchTree.setValueTree(tree);
-            cnv->pd->unlockAudioThread();
+        if(!cnv)
+            return;
+
+        auto& index = editor->pd->patchSearchIndex;
+
+        std::vector<t_canvas*> roots;
+        StringArray openFiles;
+        Array<File> directories;
+        for (auto& patch : editor->pd->patches) {
+            roots.push_back(patch->getPointer().get());
+
+            auto file = patch->getCurrentFile();
+            if (file.existsAsFile()) {
+                openFiles.add(file.getFullPathName());
+                directories.addIfNotAlreadyThere(file.getParentDirectory());
+            }
+        }
+        index.removeUnusedCanvases(roots);
+
+        // Abstractions on disk that aren't open can only be found with a search query
+        for (auto path : SettingsFile::getInstance()->getPathsTree()) {
+            directories.addIfNotAlreadyThere(File(path.getProperty("Path").toString()));
         }
+        if (directories != indexedDirectories) {
+            indexedDirectories = directories;
+            fileIndex.setDirectories(directories);
+        }
+
+        auto tree = generatePatchTree(cnv->patch.getPointer().get());
+        if (!queryWords.isEmpty()) {
+            addFileResults(tree, openFiles);
+        }
+
+        patchTree.setValueTree(tree);
+        patchTree.setFilterString(queryWords.isEmpty() ? String() : input.getText());
     }
     
     void grabFocus()
@@ -206,55 +255,69 @@ public:
         patchTree.setBounds(tableBounds);
     }
 
-    ValueTree generatePatchTree(pd::Patch::Ptr patch, void* topLevel = nullptr)
+    ValueTree generatePatchTree(t_canvas* patch, void* topLevel = nullptr)
     {
         ValueTree patchTree("Patch");
-        for (auto objectPtr : patch->getObjects()) {
-            if (auto object = objectPtr.get<t_pd>()) {
-                auto* top = topLevel ? topLevel : object.get();
-                String type = pd::Interface::getObjectClassName(object.get());
+        for (auto const& entry : editor->pd->patchSearchIndex.getEntries(patch)) {
+            auto* top = topLevel ? topLevel : entry.object;
+            auto positionText = " (" + String(entry.x) + ":" + String(entry.y) + ")";
+
+            ValueTree element("Object");
+            if (entry.subpatch) {
+                ValueTree subpatchTree = generatePatchTree(entry.subpatch, top);
+                element.copyPropertiesAndChildrenFrom(subpatchTree, nullptr);
+
+                element.setProperty("Name", entry.text, nullptr);
+                element.setProperty("Icon", entry.isAbstraction ? Icons::File : Icons::Object, nullptr);
+            } else {
+                element.setProperty("Name", entry.text.upToFirstOccurrenceOf(" ", false, false), nullptr);
+                element.setProperty("Icon", Icons::Object, nullptr);
+            }
+
+            element.setProperty("RightText", positionText, nullptr);
+            element.setProperty("Tokens", entry.tokens, nullptr);
+            element.setProperty("Object", reinterpret_cast<int64>(entry.object), nullptr);
+            element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
 
-                if (!pd::Interface::checkObject(object.get()))
-                    continue;
+            patchTree.appendChild(element, nullptr);
+        }
 
-                char* objectText;
-                int len;
-                pd::Interface::getObjectText(object.cast<t_text>(), &objectText, &len);
+        return patchTree;
+    }
 
-                int x, y, w, h;
-                pd::Interface::getObjectBounds(patch->getPointer().get(), object.cast<t_gobj>(), &x, &y, &w, &h);
+    // Adds matches from patch files that aren't open, clicking them opens the file
+    void addFileResults(ValueTree& tree, StringArray const& openFiles)
+    {
+        for (auto const& result : fileIndex.search(queryWords, openFiles, 100)) {
+            auto path = result.file.getFullPathName();
 
-                auto name = String::fromUTF8(objectText, len);
-                auto positionText = " (" + String(x) + ":" + String(y) + ")";
+            ValueTree fileElement("Object");
+            fileElement.setProperty("Name", result.file.getFileName(), nullptr);
+            fileElement.setProperty("RightText", " (" + result.file.getParentDirectory().getFileName() + ")", nullptr);
+            fileElement.setProperty("Icon", Icons::File, nullptr);
+            fileElement.setProperty("Tokens", pd::getSearchTokens(result.file.getFileNameWithoutExtension()), nullptr);
+            fileElement.setProperty("File", path, nullptr);
 
+            for (auto const& object : result.objects) {
                 ValueTree element("Object");
-                if (type == "canvas" || type == "graph") {
-                    pd::Patch::Ptr subpatch = new pd::Patch(objectPtr, editor->pd, false);
-                    ValueTree subpatchTree = generatePatchTree(subpatch, top);
-                    element.copyPropertiesAndChildrenFrom(subpatchTree, nullptr);
-
-                    element.setProperty("Name", name, nullptr);
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", canvas_isabstraction(subpatch->getPointer().get()) ? Icons::File : Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
-                } else {
-                    element.setProperty("Name", name.upToFirstOccurrenceOf(" ", false, false), nullptr);
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
-                }
-
-                patchTree.appendChild(element, nullptr);
+                element.setProperty("Name", object.text, nullptr);
+                element.setProperty("RightText", " (" + String(object.x) + ":" + String(object.y) + ")", nullptr);
+                element.setProperty("Icon", Icons::Object, nullptr);
+                element.setProperty("Tokens", object.tokens, nullptr);
+                element.setProperty("File", path, nullptr);
+                fileElement.appendChild(element, nullptr);
             }
-        }
 
-        return patchTree;
+            tree.appendChild(fileElement, nullptr);
+        }
     }
 
     SafePointer<Canvas> currentCanvas;
     PluginEditor* editor;
     ValueTreeViewerComponent patchTree = ValueTreeViewerComponent("(Subpatch)");
     SearchEditor input;
+
+    StringArray queryWords;
+    pd::PatchFileIndex fileIndex;
+    Array<File> indexedDirectories;
 };
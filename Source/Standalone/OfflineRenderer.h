@@ -0,0 +1,404 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+// Renders patches to audio files without opening a window, as fast as the CPU allows
+//
+// Render a single patch:
+//   plugdata --render <patch.pd> --output <file.wav> [--duration 10] [--input <file.wav>] [--midi <file.mid>]
+//            [--sample-rate 44100] [--channels 2] [--block-size 512] [--oversampling 0] [--seed 0] [--bpm 120] [--param name=value ...]
+//
+// Render many patches in parallel, one process per job:
+//   plugdata --render-jobs <jobs.txt> [--jobs <number of processes>]
+//   Every non-empty line of the jobs file holds the arguments of a single --render call
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <iostream>
+#include <thread>
+
+#include "PluginProcessor.h"
+#include "Utility/PluginParameter.h"
+
+class OfflineRenderer {
+
+    struct RenderJob {
+        File patch;
+        File output;
+        File input;
+        File midi;
+        double duration = 10.0;
+        double sampleRate = 44100.0;
+        double bpm = 120.0;
+        int numChannels = 2;
+        int blockSize = 512;
+        int oversampling = 0;
+        int64 seed = 0;
+        StringPairArray parameters;
+
+        bool parse(StringArray const& args, String& error)
+        {
+            for (int i = 0; i < args.size(); i++) {
+                auto const& arg = args[i];
+                auto const hasValue = i + 1 < args.size();
+                auto value = hasValue ? args[i + 1] : String();
+                auto getFile = [&value]() { return File::getCurrentWorkingDirectory().getChildFile(value); };
+
+                if (arg == "--render" && hasValue) {
+                    patch = getFile();
+                } else if (arg == "--output" && hasValue) {
+                    output = getFile();
+                } else if (arg == "--input" && hasValue) {
+                    input = getFile();
+                } else if (arg == "--midi" && hasValue) {
+                    midi = getFile();
+                } else if (arg == "--duration" && hasValue) {
+                    duration = value.getDoubleValue();
+                } else if (arg == "--sample-rate" && hasValue) {
+                    sampleRate = value.getDoubleValue();
+                } else if (arg == "--bpm" && hasValue) {
+                    bpm = value.getDoubleValue();
+                } else if (arg == "--channels" && hasValue) {
+                    numChannels = value.getIntValue();
+                } else if (arg == "--block-size" && hasValue) {
+                    blockSize = value.getIntValue();
+                } else if (arg == "--oversampling" && hasValue) {
+                    oversampling = std::clamp(value.getIntValue(), 0, 3);
+                } else if (arg == "--seed" && hasValue) {
+                    seed = value.getLargeIntValue();
+                } else if (arg == "--param" && hasValue && value.contains("=")) {
+                    parameters.set(value.upToFirstOccurrenceOf("=", false, false), value.fromFirstOccurrenceOf("=", false, false));
+                } else {
+                    error = "Unknown argument: " + arg;
+                    return false;
+                }
+                i++;
+            }
+
+            if (!patch.existsAsFile()) {
+                error = "Patch not found: " + patch.getFullPathName();
+            } else if (output == File()) {
+                error = "No output file specified";
+            } else if (input != File() && !input.existsAsFile()) {
+                error = "Input file not found: " + input.getFullPathName();
+            } else if (midi != File() && !midi.existsAsFile()) {
+                error = "MIDI file not found: " + midi.getFullPathName();
+            } else if (duration <= 0.0 || sampleRate <= 0.0 || numChannels <= 0 || blockSize <= 0) {
+                error = "Duration, sample rate, channels and block size need to be positive";
+            }
+
+            return error.isEmpty();
+        }
+    };
+
+    // Gives the patch a sample-accurate transport, so playhead-driven patches render the same way every time
+    struct OfflinePlayHead : public AudioPlayHead {
+        Optional<PositionInfo> getPosition() const override
+        {
+            PositionInfo info;
+            info.setIsPlaying(true);
+            info.setTimeInSamples(timeInSamples);
+            info.setTimeInSeconds(static_cast<double>(timeInSamples) / sampleRate);
+            info.setBpm(bpm);
+            info.setTimeSignature(TimeSignature {});
+            info.setPpqPosition((static_cast<double>(timeInSamples) / sampleRate) * (bpm / 60.0));
+            return info;
+        }
+
+        int64 timeInSamples = 0;
+        double sampleRate = 44100.0;
+        double bpm = 120.0;
+    };
+
+public:
+    // Renders on a background thread, so the message loop keeps running and can drain everything
+    // the processor posts to it. Quits the application with the render's exit code when done
+    class RenderThread : public Thread {
+    public:
+        explicit RenderThread(StringArray renderArguments)
+            : Thread("Offline Render")
+            , arguments(std::move(renderArguments))
+        {
+        }
+
+        void run() override
+        {
+            auto const result = OfflineRenderer::run(arguments);
+            MessageManager::callAsync([result]() {
+                JUCEApplicationBase::setApplicationReturnValue(result);
+                JUCEApplicationBase::quit();
+            });
+        }
+
+    private:
+        StringArray arguments;
+    };
+
+    static bool isRenderCommand(StringArray const& args)
+    {
+        return args.contains("--render") || args.contains("--render-jobs");
+    }
+
+    // Returns the exit code for the application
+    static int run(StringArray args)
+    {
+        for (auto& arg : args) {
+            arg = arg.trim().unquoted();
+        }
+
+        if (args.contains("--render-jobs")) {
+            return runJobs(args);
+        }
+
+        RenderJob job;
+        String error;
+        if (!job.parse(args, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+
+        return render(job) ? 0 : 1;
+    }
+
+private:
+    static bool render(RenderJob const& job)
+    {
+        std::srand(static_cast<unsigned int>(job.seed));
+        Random::getSystemRandom().setSeed(job.seed);
+
+        auto processor = std::make_unique<PluginProcessor>();
+
+        OfflinePlayHead playhead;
+        playhead.sampleRate = job.sampleRate;
+        playhead.bpm = job.bpm;
+
+        processor->setPlayHead(&playhead);
+        processor->setPlayConfigDetails(job.numChannels, job.numChannels, job.sampleRate, job.blockSize);
+        // Don't use setOversampling here, that would write to the user's settings file
+        processor->oversampling = job.oversampling;
+        processor->setNonRealtime(true);
+        processor->prepareToPlay(job.sampleRate, job.blockSize);
+
+        auto patch = processor->loadPatch(job.patch, nullptr);
+        if (!patch) {
+            std::cerr << "Couldn't open patch: " << job.patch.getFullPathName() << std::endl;
+            return false;
+        }
+
+        for (auto* parameter : processor->getParameters()) {
+            if (auto* pluginParameter = dynamic_cast<PlugDataParameter*>(parameter)) {
+                auto const name = pluginParameter->getTitle();
+                if (job.parameters.containsKey(name)) {
+                    pluginParameter->setValue(pluginParameter->getValueForText(job.parameters[name]));
+                }
+            }
+        }
+
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        // Audio files are streamed one block at a time, so the length of a render isn't limited by memory
+        std::unique_ptr<AudioFormatReader> reader;
+        if (job.input != File()) {
+            reader.reset(formatManager.createReaderFor(job.input));
+            if (!reader) {
+                std::cerr << "Couldn't read input file: " << job.input.getFullPathName() << std::endl;
+                return false;
+            }
+            if (!approximatelyEqual(reader->sampleRate, job.sampleRate)) {
+                std::cerr << "Warning: input file sample rate doesn't match the render sample rate, it will not be resampled" << std::endl;
+            }
+        }
+
+        MidiMessageSequence midiSequence;
+        if (job.midi != File()) {
+            FileInputStream midiStream(job.midi);
+            MidiFile midiFile;
+            if (!midiStream.openedOk() || !midiFile.readFrom(midiStream)) {
+                std::cerr << "Couldn't read MIDI file: " << job.midi.getFullPathName() << std::endl;
+                return false;
+            }
+
+            midiFile.convertTimestampTicksToSeconds();
+            for (int track = 0; track < midiFile.getNumTracks(); track++) {
+                midiSequence.addSequence(*midiFile.getTrack(track), 0.0);
+            }
+            midiSequence.sort();
+        }
+
+        auto* outputFormat = formatManager.findFormatForFileExtension(job.output.getFileExtension());
+        if (!outputFormat) {
+            outputFormat = formatManager.findFormatForFileExtension("wav");
+        }
+
+        job.output.deleteFile();
+        auto outputStream = std::unique_ptr<OutputStream>(job.output.createOutputStream());
+        if (!outputStream) {
+            std::cerr << "Couldn't create output file: " << job.output.getFullPathName() << std::endl;
+            return false;
+        }
+
+        auto writer = std::unique_ptr<AudioFormatWriter>(outputFormat->createWriterFor(outputStream.get(), job.sampleRate, job.numChannels, 24, {}, 0));
+        if (!writer) {
+            std::cerr << "Couldn't write " << outputFormat->getFormatName() << " with " << job.numChannels << " channels at " << job.sampleRate << "Hz" << std::endl;
+            return false;
+        }
+        // The writer owns the stream now
+        outputStream.release();
+
+        AudioBuffer<float> buffer(job.numChannels, job.blockSize);
+        MidiBuffer midiBuffer;
+
+        auto const totalSamples = static_cast<int64>(std::round(job.duration * job.sampleRate));
+        int midiEventIndex = 0;
+
+        auto const startTime = Time::getMillisecondCounterHiRes();
+
+        for (int64 position = 0; position < totalSamples; position += job.blockSize) {
+            if (Thread::currentThreadShouldExit()) {
+                std::cerr << "Render cancelled: " << job.patch.getFileName() << std::endl;
+                return false;
+            }
+
+            buffer.clear();
+
+            if (reader) {
+                reader->read(&buffer, 0, job.blockSize, position, true, true);
+            }
+
+            auto const blockEnd = position + job.blockSize;
+            while (midiEventIndex < midiSequence.getNumEvents()) {
+                auto const& message = midiSequence.getEventPointer(midiEventIndex)->message;
+                auto const samplePosition = static_cast<int64>(std::round(message.getTimeStamp() * job.sampleRate));
+                if (samplePosition >= blockEnd)
+                    break;
+
+                if (!message.isMetaEvent()) {
+                    midiBuffer.addEvent(message, static_cast<int>(std::max<int64>(0, samplePosition - position)));
+                }
+                midiEventIndex++;
+            }
+
+            playhead.timeInSamples = position;
+            processor->processBlock(buffer, midiBuffer);
+            midiBuffer.clear();
+
+            // The last block is always processed in full, but only the requested duration gets written
+            auto const numSamplesToWrite = static_cast<int>(std::min<int64>(job.blockSize, totalSamples - position));
+            if (!writer->writeFromAudioSampleBuffer(buffer, 0, numSamplesToWrite)) {
+                std::cerr << "Failed to write to " << job.output.getFullPathName() << std::endl;
+                return false;
+            }
+        }
+
+        writer.reset();
+
+        processor->releaseResources();
+        processor->patches.removeFirstMatchingValue(patch);
+        patch = nullptr;
+        processor->setPlayHead(nullptr);
+
+        auto const renderTime = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        std::cout << "Rendered " << job.patch.getFileName() << " to " << job.output.getFullPathName() << ": " << job.duration << "s of audio in " << renderTime << "s (" << (renderTime > 0.0 ? job.duration / renderTime : 0.0) << "x realtime)" << std::endl;
+
+        return true;
+    }
+
+    // Every job runs in its own process, the standalone can only have a single Pd instance per process
+    static int runJobs(StringArray const& args)
+    {
+        auto const jobsFileIndex = args.indexOf("--render-jobs") + 1;
+        auto const jobsFile = File::getCurrentWorkingDirectory().getChildFile(args[jobsFileIndex]);
+        if (!jobsFile.existsAsFile()) {
+            std::cerr << "Jobs file not found: " << jobsFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        auto const numJobsIndex = args.indexOf("--jobs");
+        auto const maxProcesses = numJobsIndex >= 0 ? std::max(1, args[numJobsIndex + 1].getIntValue()) : SystemStats::getNumCpus();
+
+        StringArray lines;
+        jobsFile.readLines(lines);
+        lines.removeEmptyStrings();
+
+        auto const executable = File::getSpecialLocation(File::currentExecutableFile).getFullPathName();
+
+        struct RunningJob {
+            std::unique_ptr<ChildProcess> process;
+            String description;
+            MemoryBlock output;
+            std::thread outputReader;
+        };
+
+        std::vector<std::unique_ptr<RunningJob>> running;
+        int nextJob = 0;
+        int failures = 0;
+
+        while (nextJob < lines.size() || !running.empty()) {
+            // When the application quits halfway, stop the jobs that are still running and don't start new ones
+            if (Thread::currentThreadShouldExit() && nextJob < lines.size()) {
+                failures += lines.size() - nextJob;
+                nextJob = lines.size();
+                for (auto& job : running) {
+                    job->process->kill();
+                }
+            }
+
+            while (nextJob < lines.size() && running.size() < static_cast<size_t>(maxProcesses)) {
+                auto command = StringArray::fromTokens(lines[nextJob], true);
+                for (auto& token : command) {
+                    token = token.unquoted();
+                }
+                if (!command.contains("--render"))
+                    command.insert(0, "--render");
+                command.insert(0, executable);
+
+                auto process = std::make_unique<ChildProcess>();
+                if (process->start(command)) {
+                    auto job = std::make_unique<RunningJob>();
+                    job->process = std::move(process);
+                    job->description = lines[nextJob];
+
+                    // Keep reading while the job runs, a job that prints a lot would block once the pipe is full
+                    job->outputReader = std::thread([job = job.get()]() {
+                        char buffer[4096];
+                        while (auto const numRead = job->process->readProcessOutput(buffer, sizeof(buffer))) {
+                            job->output.append(buffer, static_cast<size_t>(numRead));
+                        }
+                    });
+
+                    running.push_back(std::move(job));
+                } else {
+                    std::cerr << "Couldn't start job: " << lines[nextJob] << std::endl;
+                    failures++;
+                }
+                nextJob++;
+            }
+
+            for (auto it = running.begin(); it != running.end();) {
+                auto& job = **it;
+                if (job.process->isRunning()) {
+                    ++it;
+                    continue;
+                }
+
+                // The reader stops at the end of the output, after the process has exited
+                job.outputReader.join();
+                std::cout << job.output.toString();
+                if (job.process->getExitCode() != 0) {
+                    std::cerr << "Job failed: " << job.description << std::endl;
+                    failures++;
+                }
+                it = running.erase(it);
+            }
+
+            Thread::sleep(5);
+        }
+
+        std::cout << (lines.size() - failures) << " of " << lines.size() << " jobs rendered" << std::endl;
+        return failures > 0 ? 1 : 0;
+    }
+};
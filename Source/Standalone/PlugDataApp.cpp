@@ -25,6 +25,7 @@
 #include "Pd/Setup.h"
 
 #include "PlugDataWindow.h"
+#include "OfflineRenderer.h"
 #include "Canvas.h"
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
@@ -98,6 +99,14 @@ public:
 
     void initialise(String const& arguments) override
     {
+        // Command-line rendering doesn't need a window or audio device
+        auto args = StringArray::fromTokens(arguments, true);
+        if (OfflineRenderer::isRenderCommand(args)) {
+            renderThread = std::make_unique<OfflineRenderer::RenderThread>(args);
+            renderThread->startThread();
+            return;
+        }
+
         LookAndFeel::getDefaultLookAndFeel().setColour(ResizableWindow::backgroundColourId, Colours::transparentBlack);
 
         pluginHolder = std::make_unique<StandalonePluginHolder>(appProperties.getUserSettings(), false, "");
@@ -139,8 +148,13 @@ public:
 
     void shutdown() override
     {
+        if (renderThread)
+            renderThread->stopThread(-1);
+        renderThread = nullptr;
+
         mainWindow = nullptr;
-        pluginHolder->stopPlaying();
+        if (pluginHolder)
+            pluginHolder->stopPlaying();
         pluginHolder = nullptr;
         appProperties.saveIfNeeded();
     }
@@ -238,7 +252,8 @@ public:
 
 protected:
     ApplicationProperties appProperties;
-    PlugDataWindow* mainWindow;
+    PlugDataWindow* mainWindow = nullptr;
+    std::unique_ptr<OfflineRenderer::RenderThread> renderThread;
 };
 
 void PlugDataWindow::closeAllPatches()
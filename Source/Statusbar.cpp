@@ -896,7 +896,7 @@ void StatusbarSource::process(bool hasMidiInput, bool hasMidiOutput, int channel
 void StatusbarSource::prepareToPlay(int nChannels)
 {
     numChannels = nChannels;
-    peakBuffer.reset(sampleRate, bufferSize, nChannels);
+    levelMeter.reset(sampleRate, nChannels);
 }
 
 void StatusbarSource::timerCallback()
@@ -923,7 +923,7 @@ void StatusbarSource::timerCallback()
             listener->audioProcessedChanged(hasProcessedAudio);
     }
 
-    auto peak = peakBuffer.getPeak();
+    auto peak = levelMeter.getPeak();
 
     for (auto* listener : listeners) {
         listener->audioLevelChanged(peak);
@@ -10,7 +10,7 @@
 #include "LookAndFeel.h"
 #include "Utility/SettingsFile.h"
 #include "Utility/ModifierKeyListener.h"
-#include "Utility/AudioSampleRingBuffer.h"
+#include "Utility/AudioLevelMeter.h"
 #include "Components/Buttons.h"
 
 class Canvas;
@@ -50,7 +50,7 @@ public:
 
     void setCPUUsage(float cpuUsage);
 
-    AudioSampleRingBuffer peakBuffer;
+    AudioLevelMeter levelMeter;
 
 private:
     std::atomic<int> lastMidiReceivedTime = 0;
@@ -0,0 +1,162 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+
+// Wait-free level metering for the statusbar
+// The audio thread reduces each block to a peak and RMS value per channel, and publishes them through a seqlock once per 1/60 s window
+// The message thread only reads these precomputed values, so we never copy samples or take a lock on the audio thread
+class AudioLevelMeter {
+public:
+    // The statusbar only displays two channels, so there's no point in metering the others
+    static constexpr int maxChannels = 2;
+
+    struct Levels {
+        float peak[maxChannels] = { 0.0f };
+        float rms[maxChannels] = { 0.0f };
+    };
+
+    // Should not be called while the audio thread is writing
+    void reset(double sampleRate, int numChannels)
+    {
+        windowSize = jmax(1, static_cast<int>(sampleRate / 60));
+        numMeteredChannels = jmin(numChannels, maxChannels);
+        clearAccumulators();
+        publish({});
+    }
+
+    // Audio thread
+    void write(AudioBuffer<float> const& samples)
+    {
+        auto const numSamples = samples.getNumSamples();
+        auto const numChannels = jmin(numMeteredChannels, samples.getNumChannels());
+
+        for (int ch = 0; ch < numChannels; ch++) {
+            auto const* data = samples.getReadPointer(ch);
+            auto const range = FloatVectorOperations::findMinAndMax(data, numSamples);
+
+            peakAccumulator[ch] = jmax(peakAccumulator[ch], -range.getStart(), range.getEnd());
+            squareAccumulator[ch] += getSumOfSquares(data, numSamples);
+        }
+
+        numAccumulatedSamples += numSamples;
+
+        if (numAccumulatedSamples >= windowSize) {
+            Levels levels;
+            for (int ch = 0; ch < numChannels; ch++) {
+                levels.peak[ch] = peakAccumulator[ch];
+                levels.rms[ch] = std::sqrt(squareAccumulator[ch] / static_cast<float>(numAccumulatedSamples));
+            }
+            publish(levels);
+            clearAccumulators();
+        }
+    }
+
+    // Message thread: returns the most recently published levels
+    Levels getLevels() const
+    {
+        Levels levels;
+        while (true) {
+            auto const before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+
+            for (int ch = 0; ch < maxChannels; ch++) {
+                levels.peak[ch] = publishedPeak[ch].load(std::memory_order_relaxed);
+                levels.rms[ch] = publishedRMS[ch].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+                return levels;
+        }
+    }
+
+    // Message thread: peak levels, scaled for display on the statusbar level meter
+    Array<float> getPeak()
+    {
+        // Fall back to silence when the audio thread stopped publishing
+        auto const currentTime = Time::getMillisecondCounter();
+        auto const currentSequence = sequence.load(std::memory_order_acquire);
+        if (currentSequence != lastReadSequence) {
+            lastReadSequence = currentSequence;
+            lastReadTime = currentTime;
+        } else if (currentTime - lastReadTime > 100) {
+            return { 0.0f, 0.0f };
+        }
+
+        auto const levels = getLevels();
+
+        Array<float> peak;
+        for (int ch = 0; ch < maxChannels; ch++) {
+            peak.add(std::sqrt(levels.peak[ch]));
+        }
+        return peak;
+    }
+
+private:
+    void publish(Levels const& levels)
+    {
+        auto const current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (int ch = 0; ch < maxChannels; ch++) {
+            publishedPeak[ch].store(levels.peak[ch], std::memory_order_relaxed);
+            publishedRMS[ch].store(levels.rms[ch], std::memory_order_relaxed);
+        }
+
+        sequence.store(current + 2, std::memory_order_release);
+    }
+
+    void clearAccumulators()
+    {
+        numAccumulatedSamples = 0;
+        for (int ch = 0; ch < maxChannels; ch++) {
+            peakAccumulator[ch] = 0.0f;
+            squareAccumulator[ch] = 0.0f;
+        }
+    }
+
+    // Uses four independent partial sums, which lets the compiler vectorise the loop
+    static float getSumOfSquares(float const* data, int numSamples)
+    {
+        float sums[4] = { 0.0f };
+
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4) {
+            for (int j = 0; j < 4; j++) {
+                sums[j] += data[i + j] * data[i + j];
+            }
+        }
+
+        float sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        for (; i < numSamples; i++) {
+            sum += data[i] * data[i];
+        }
+
+        return sum;
+    }
+
+    // Audio thread only
+    int windowSize = 1;
+    int numMeteredChannels = 0;
+    int numAccumulatedSamples = 0;
+    float peakAccumulator[maxChannels] = { 0.0f };
+    float squareAccumulator[maxChannels] = { 0.0f };
+
+    // Shared between threads
+    std::atomic<uint32> sequence = 0;
+    std::atomic<float> publishedPeak[maxChannels] = {};
+    std::atomic<float> publishedRMS[maxChannels] = {};
+
+    // Message thread only
+    uint32 lastReadSequence = 0;
+    uint32 lastReadTime = 0;
+};
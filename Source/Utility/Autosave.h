@@ -1,33 +1,308 @@
 #pragma once
+#include <map>
+#include <set>
 #include <readerwriterqueue.h>
 #include "Dialogs/Dialogs.h"
 
+// Keeps the autosaved patches, shared by all editors
+// Patches are converted to text and written to disk on a background thread. Every autosave is appended to a journal as the
+// lines that changed since the previous autosave of that patch, the full autosave file is only rewritten when the journal gets compacted
+class AutosaveJournal : public AsyncUpdater {
+
+    struct Update {
+        String path;
+        String content;
+        int64 lastModified;
+    };
+
+    static inline File const autoSaveFile = ProjectInfo::appDataDir.getChildFile(".autosave");
+    static inline File const journalFile = ProjectInfo::appDataDir.getChildFile(".autosave_journal");
+
+    static constexpr int maxAutosaves = 15;
+    static constexpr int maxJournalEntries = 64;
+
+public:
+    AutosaveJournal()
+    {
+        if (autoSaveFile.existsAsFile()) {
+            FileInputStream istream(autoSaveFile);
+            tree = ValueTree::readFromStream(istream);
+            // In case something went wrong
+            if (!tree.isValid())
+                tree = ValueTree("Autosave");
+        }
+
+        // Older versions stored the patches as base64
+        if (!tree.hasProperty("Format")) {
+            for (auto save : tree) {
+                MemoryOutputStream ostream;
+                Base64::convertFromBase64(ostream, save.getProperty("Patch").toString());
+                save.setProperty("Patch", String::fromUTF8(static_cast<char const*>(ostream.getData()), ostream.getDataSize()), nullptr);
+            }
+            tree.setProperty("Format", 2, nullptr);
+        }
+
+        for (auto save : tree) {
+            auto& saved = savedPatches[save.getProperty("Path").toString()];
+            saved.content = save.getProperty("Patch").toString();
+            saved.lastModified = static_cast<int64>(save.getProperty("LastModified"));
+        }
+
+        // Replay whatever was journaled since the last compaction, the last entry may be incomplete if we crashed while writing it
+        if (journalFile.existsAsFile()) {
+            FileInputStream istream(journalFile);
+            while (!istream.isExhausted()) {
+                auto entry = ValueTree::readFromStream(istream);
+                if (!entry.isValid())
+                    break;
+
+                auto const path = entry.getProperty("Path").toString();
+                auto& saved = savedPatches[path];
+                saved.content = applyDelta(saved.content, entry);
+                saved.lastModified = static_cast<int64>(entry.getProperty("LastModified"));
+                updateTree({ path, saved.content, saved.lastModified });
+            }
+        }
+
+        writer.addJob([this]() {
+            compact();
+        });
+    }
+
+    ~AutosaveJournal() override
+    {
+        // Let pending saves finish, they own their binbufs
+        // The writer runs its jobs in order, so once this one has run, all saves before it are done
+        struct FlushJob : public ThreadPoolJob {
+            FlushJob()
+                : ThreadPoolJob("Autosave flush")
+            {
+            }
+
+            JobStatus runJob() override
+            {
+                return jobHasFinished;
+            }
+        } flush;
+
+        writer.addJob(&flush, false);
+        writer.waitForJobToFinish(&flush, -1);
+
+        cancelPendingUpdate();
+    }
+
+    // Takes ownership of the binbuf
+    void save(String const& path, t_binbuf* snapshot)
+    {
+        writer.addJob([this, path, snapshot]() {
+            char* buf;
+            int bufsize;
+            binbuf_gettext(snapshot, &buf, &bufsize);
+            binbuf_free(snapshot);
+
+            auto content = String::fromUTF8(buf, bufsize);
+            freebytes(static_cast<void*>(buf), static_cast<size_t>(bufsize) * sizeof(char));
+
+            write(path, content);
+        });
+    }
+
+    // Only use this on the message thread
+    ValueTree tree = ValueTree("Autosave");
+
+private:
+    struct SavedPatch {
+        String content;
+        int64 lastModified = 0;
+    };
+
+    void write(String const& path, String const& content)
+    {
+        auto& saved = savedPatches[path];
+        if (saved.content == content)
+            return;
+
+        // Make sure we get current time in the correct format used by the OS for file modification time
+        auto tempFile = File::createTempFile("temp_time_test");
+        tempFile.create();
+        auto time = tempFile.getCreationTime().toMilliseconds();
+        tempFile.deleteFile();
+
+        auto entry = createDelta(saved.content, content);
+        entry.setProperty("Path", path, nullptr);
+        entry.setProperty("LastModified", time, nullptr);
+
+        saved.content = content;
+        saved.lastModified = time;
+        removeOldestPatches();
+
+        {
+            FileOutputStream ostream(journalFile);
+            entry.writeToStream(ostream);
+        }
+
+        updateQueue.enqueue({ path, content, time });
+        triggerAsyncUpdate();
+
+        if (++numJournalEntries > maxJournalEntries)
+            compact();
+    }
+
+    // Writes all autosaves into a single file, and clears the journal
+    void compact()
+    {
+        auto compacted = ValueTree("Autosave");
+        compacted.setProperty("Format", 2, nullptr);
+        for (auto const& [path, saved] : savedPatches) {
+            ValueTree save("Save");
+            save.setProperty("Path", path, nullptr);
+            save.setProperty("Patch", saved.content, nullptr);
+            save.setProperty("LastModified", saved.lastModified, nullptr);
+            compacted.appendChild(save, nullptr);
+        }
+
+        TemporaryFile temp(autoSaveFile);
+        {
+            FileOutputStream ostream(temp.getFile());
+            compacted.writeToStream(ostream);
+        }
+
+        if (temp.overwriteTargetFileWithTemporary()) {
+            journalFile.deleteFile();
+            numJournalEntries = 0;
+        }
+    }
+
+    void removeOldestPatches()
+    {
+        while (savedPatches.size() > maxAutosaves) {
+            auto oldest = std::min_element(savedPatches.begin(), savedPatches.end(), [](auto const& a, auto const& b) {
+                return a.second.lastModified < b.second.lastModified;
+            });
+            savedPatches.erase(oldest);
+        }
+    }
+
+    // Stores the lines that changed, as the number of unchanged lines at the start and end plus the lines in between
+    static ValueTree createDelta(String const& oldContent, String const& newContent)
+    {
+        StringArray oldLines, newLines;
+        oldLines.addTokens(oldContent, "\n", "");
+        newLines.addTokens(newContent, "\n", "");
+
+        int prefix = 0;
+        while (prefix < oldLines.size() && prefix < newLines.size() && oldLines[prefix] == newLines[prefix])
+            prefix++;
+
+        int suffix = 0;
+        while (suffix < oldLines.size() - prefix && suffix < newLines.size() - prefix && oldLines[oldLines.size() - suffix - 1] == newLines[newLines.size() - suffix - 1])
+            suffix++;
+
+        auto const numChanged = newLines.size() - prefix - suffix;
+
+        ValueTree delta("Delta");
+        delta.setProperty("Prefix", prefix, nullptr);
+        delta.setProperty("Suffix", suffix, nullptr);
+        delta.setProperty("NumLines", numChanged, nullptr);
+        delta.setProperty("Lines", newLines.joinIntoString("\n", prefix, numChanged), nullptr);
+        return delta;
+    }
+
+    static String applyDelta(String const& oldContent, ValueTree const& delta)
+    {
+        StringArray oldLines;
+        oldLines.addTokens(oldContent, "\n", "");
+
+        int const prefix = std::min<int>(delta.getProperty("Prefix"), oldLines.size());
+        int const suffix = std::min<int>(delta.getProperty("Suffix"), oldLines.size() - prefix);
+
+        StringArray result;
+        result.addArray(oldLines, 0, prefix);
+        if (static_cast<int>(delta.getProperty("NumLines")) > 0)
+            result.addTokens(delta.getProperty("Lines").toString(), "\n", "");
+        result.addArray(oldLines, oldLines.size() - suffix, suffix);
+
+        return result.joinIntoString("\n");
+    }
+
+    void updateTree(Update const& update)
+    {
+        auto existingPatch = tree.getChildWithProperty("Path", update.path);
+
+        if (existingPatch.isValid()) {
+            existingPatch.setProperty("Patch", update.content, nullptr);
+            existingPatch.setProperty("LastModified", update.lastModified, nullptr);
+        } else {
+            ValueTree newAutoSave = ValueTree("Save");
+            newAutoSave.setProperty("Path", update.path, nullptr);
+            newAutoSave.setProperty("Patch", update.content, nullptr);
+            newAutoSave.setProperty("LastModified", update.lastModified, nullptr);
+            tree.addChild(newAutoSave, 0, nullptr);
+
+            if (tree.getNumChildren() > maxAutosaves) {
+                int64 oldestTime = std::numeric_limits<int64>::max();
+                int oldestIdx = -1;
+                int currentIdx = 0;
+                for (auto autoSave : tree) {
+                    auto modifiedTime = static_cast<int64>(autoSave.getProperty("LastModified"));
+                    if (modifiedTime < oldestTime) {
+                        oldestTime = modifiedTime;
+                        oldestIdx = currentIdx;
+                    }
+                    currentIdx++;
+                }
+                if (oldestIdx >= 0) {
+                    tree.removeChild(oldestIdx, nullptr);
+                }
+            }
+        }
+    }
+
+    void handleAsyncUpdate() override
+    {
+        Update update;
+        while (updateQueue.try_dequeue(update)) {
+            updateTree(update);
+        }
+    }
+
+    // Only accessed from the writer thread, after construction
+    std::map<String, SavedPatch> savedPatches;
+    int numJournalEntries = 0;
+
+    moodycamel::ReaderWriterQueue<Update> updateQueue;
+    ThreadPool writer = ThreadPool(1);
+};
+
 class Autosave : public Timer
-    , public AsyncUpdater
     , public Value::Listener {
 
-    static inline File const autoSaveFile = ProjectInfo::appDataDir.getChildFile(".autosave");
-    static inline ValueTree autoSaveTree = ValueTree("Autosave");
+    // What a subpatch saved to during an earlier autosave
+    struct SavedSubpatch {
+        pd::WeakReference ref;
+        uint64 signature;
+        t_binbuf* content;
+        int numReuses = 0;
+        bool visited = true;
+    };
+
+    // Subpatches that weren't edited are reused this many times before we save them again
+    // Not every change goes through the undo queue, some objects save state that changes while they run
+    static constexpr int maxSubpatchReuses = 8;
+
     Value autosaveInterval;
     Value autosaveEnabled;
 
     PluginProcessor* pd;
-    moodycamel::ReaderWriterQueue<std::pair<String, String>> autoSaveQueue;
+    SharedResourcePointer<AutosaveJournal> journal;
+
+    // Only accessed on the message thread, with the audio lock held
+    std::map<t_canvas*, SavedSubpatch> savedSubpatches;
 
 public:
     Autosave(PluginProcessor* procesor)
         : pd(procesor)
     {
-        if (!autoSaveFile.existsAsFile()) {
-            autoSaveFile.create();
-        } else {
-            FileInputStream istream(autoSaveFile);
-            autoSaveTree = ValueTree::readFromStream(istream);
-            // In case something went wrong
-            if (!autoSaveTree.isValid())
-                autoSaveTree = ValueTree("Autosave");
-        }
-
         autosaveEnabled.referTo(SettingsFile::getInstance()->getPropertyAsValue("autosave_enabled"));
 
         // autosave timer trigger
@@ -36,6 +311,12 @@ public:
         startTimer(1000 * getValue<int>(autosaveInterval));
     }
 
+    ~Autosave() override
+    {
+        for (auto& [cnv, saved] : savedSubpatches)
+            binbuf_free(saved.content);
+    }
+
     // Call this whenever we load a file
     void checkForMoreRecentAutosave(File& patchPath, std::function<void()> callback)
     {
@@ -43,7 +324,7 @@ public:
         if (!editor)
             return;
 
-        auto lastAutoSavedPatch = autoSaveTree.getChildWithProperty("Path", patchPath.getFullPathName());
+        auto lastAutoSavedPatch = journal->tree.getChildWithProperty("Path", patchPath.getFullPathName());
         auto autoSavedTime = static_cast<int64>(lastAutoSavedPatch.getProperty("LastModified"));
         auto fileChangedTime = patchPath.getLastModificationTime().toMilliseconds();
         if (lastAutoSavedPatch.isValid() && autoSavedTime > fileChangedTime) {
@@ -52,10 +333,7 @@ public:
             Dialogs::showOkayCancelDialog(
                 &editor->openedDialog, editor, "Restore autosave? (last autosave is " + String(minutesDifference) + " minutes newer)", [lastAutoSavedPatch, patchPath, callback](bool useAutosaved) {
                     if (useAutosaved) {
-                        MemoryOutputStream ostream;
-                        Base64::convertFromBase64(ostream, lastAutoSavedPatch.getProperty("Patch").toString());
-                        auto autosavedPatch = String::fromUTF8((const char*)ostream.getData(), ostream.getDataSize());
-                        patchPath.replaceWithText(autosavedPatch);
+                        patchPath.replaceWithText(lastAutoSavedPatch.getProperty("Patch").toString());
                         // TODO: instead of replacing, it would be better to load it as a string, (but also with the correct patch path)
                     }
 
@@ -81,94 +359,129 @@ private:
         if (!getValue<bool>(autosaveEnabled))
             return;
 
-        pd->enqueueFunctionAsync([this]() {
-            save();
-        });
+        save();
     }
 
+    // Only holds the audio lock while saving a dirty patch into a binbuf, and takes it again for every patch
+    // Subpatches that weren't edited since the last autosave are copied from what they saved to back then
+    // Converting them to text, skipping unchanged patches and writing to disk happens on the journal's thread
     void save()
     {
+        for (auto& [cnv, saved] : savedSubpatches)
+            saved.visited = false;
+
         for (auto& patch : pd->patches) {
-            if (!patch->isDirty())
-                continue;
+            auto patchFile = patch->getPatchFile();
 
-            // Check if patch is a root canvas
-            bool isRootCanvas = false;
-            for (auto* x = pd_getcanvaslist(); x; x = x->gl_next) {
-                if (x == patch->getPointer().get()) {
-                    isRootCanvas = true;
-                    break;
-                }
-            }
-            if (!isRootCanvas)
+            // Simple way to filter out plugdata default patches which we don't want to save.
+            if (isInternalPatch(patchFile))
                 continue;
 
-            auto patchFile = patch->getPatchFile();
+            t_binbuf* snapshot = nullptr;
 
-            // Simple way to filter out plugdata default patches which we don't want to save.
-            if (!isInternalPatch(patchFile)) {
-                autoSaveQueue.enqueue({ patchFile.getFullPathName(), patch->getCanvasContent() });
+            pd->lockAudioThread();
+            pd->setThis();
+
+            auto* cnv = patch->getPointer().get();
+            if (cnv && patch->isDirty() && isRootCanvas(cnv)) {
+                snapshot = pd::Interface::getCanvasBinbuf(cnv, [this](t_gobj* obj, t_binbuf* b) {
+                    saveObject(obj, b);
+                });
             }
+
+            pd->unlockAudioThread();
+
+            if (snapshot)
+                journal->save(patchFile.getFullPathName(), snapshot);
         }
 
-        triggerAsyncUpdate();
+        // Forget subpatches that were deleted, or that belong to patches that were closed
+        for (auto it = savedSubpatches.begin(); it != savedSubpatches.end();) {
+            if (!it->second.visited) {
+                binbuf_free(it->second.content);
+                it = savedSubpatches.erase(it);
+            } else {
+                ++it;
+            }
+        }
     }
 
-    bool isInternalPatch(File const& patch)
+    // Call this with the audio thread locked, and our instance selected
+    void saveObject(t_gobj* obj, t_binbuf* b)
     {
-        auto const pathName = patch.getFullPathName();
-        return pathName.contains("Documents/plugdata/Abstractions") || pathName.contains("Documents\\plugdata\\Abstractions") || pathName.contains("Documents/plugdata/Documentation") || pathName.contains("Documents\\plugdata\\Documentation") || pathName.contains("Documents/plugdata/Extra") || pathName.contains("Documents\\plugdata\\Extra") || patch.getParentDirectory() == File::getSpecialLocation(File::tempDirectory);
-    }
+        auto* subpatch = pd_checkglist(&obj->g_pd);
+        if (!subpatch || canvas_isabstraction(subpatch) || canvas_istable(subpatch)) {
+            gobj_save(obj, b);
+            return;
+        }
 
-    void handleAsyncUpdate() override
-    {
-        std::pair<String, String> pathAndContent;
-        while (autoSaveQueue.try_dequeue(pathAndContent)) {
-            auto& [path, content] = pathAndContent;
+        bool canReuse = true;
+        auto const signature = getSignature(subpatch, canReuse);
+
+        auto saved = savedSubpatches.find(subpatch);
+        if (saved != savedSubpatches.end()) {
+            auto& [ref, lastSignature, content, numReuses, visited] = saved->second;
+            if (canReuse && ref.isValid() && lastSignature == signature && numReuses < maxSubpatchReuses) {
+                binbuf_add(b, binbuf_getnatom(content), binbuf_getvec(content));
+                numReuses++;
+                visited = true;
+                return;
+            }
 
-            // Make sure we get current time in the correct format used by the OS for file modification time
-            auto tempFile = File::createTempFile("temp_time_test");
-            tempFile.create();
-            auto time = tempFile.getCreationTime().toMilliseconds();
-            tempFile.deleteFile();
+            binbuf_free(content);
+            savedSubpatches.erase(saved);
+        }
 
-            auto existingPatch = autoSaveTree.getChildWithProperty("Path", path);
+        auto* content = binbuf_new();
+        gobj_save(obj, content);
+        binbuf_add(b, binbuf_getnatom(content), binbuf_getvec(content));
 
-            if (existingPatch.isValid()) {
-                existingPatch.setProperty("Patch", Base64::toBase64(content), nullptr);
-                existingPatch.setProperty("LastModified", (int64)time, nullptr);
-            } else {
-                ValueTree newAutoSave = ValueTree("Save");
-                newAutoSave.setProperty("Path", path, nullptr);
-                newAutoSave.setProperty("Patch", Base64::toBase64(content), nullptr);
-                newAutoSave.setProperty("LastModified", (int64)time, nullptr);
-                autoSaveTree.addChild(newAutoSave, 0, nullptr);
-
-                if (autoSaveTree.getNumChildren() > 15) {
-                    int64 oldestTime = std::numeric_limits<int64>::max();
-                    int oldestIdx = -1;
-                    int currentIdx = 0;
-                    for (auto autoSave : autoSaveTree) {
-                        auto modifiedTime = static_cast<int64>(autoSave.getProperty("LastModified"));
-                        if (modifiedTime < oldestTime) {
-                            oldestTime = modifiedTime;
-                            oldestIdx = currentIdx;
-                        }
-                        currentIdx++;
-                    }
-                    if (oldestIdx >= 0) {
-                        autoSaveTree.removeChild(oldestIdx, nullptr);
-                    }
-                }
+        if (canReuse)
+            savedSubpatches.emplace(subpatch, SavedSubpatch { pd::WeakReference(subpatch, pd), signature, content });
+        else
+            binbuf_free(content);
+    }
+
+    // Changes whenever something is edited in this subpatch or the subpatches inside it, because every edit moves the undo queue
+    // Arrays change their data without an undo action, so subpatches that contain them are saved every time
+    static uint64 getSignature(t_canvas* cnv, bool& canReuse)
+    {
+        auto combine = [](uint64 hash, uint64 value) {
+            return (hash ^ value) * 1099511628211ull;
+        };
+
+        auto* undo = canvas_undo_get(cnv);
+        auto hash = combine(14695981039346656037ull, reinterpret_cast<uintptr_t>(undo ? undo->u_last : nullptr));
+        hash = combine(hash, static_cast<uint64>(cnv->gl_obj.te_xpix) << 32 | static_cast<uint32>(cnv->gl_obj.te_ypix));
+        hash = combine(hash, static_cast<uint64>(cnv->gl_screenx2 - cnv->gl_screenx1) << 32 | static_cast<uint32>(cnv->gl_screeny2 - cnv->gl_screeny1));
+        hash = combine(hash, static_cast<uint64>(cnv->gl_obj.te_width) << 1 | cnv->gl_mapped);
+
+        for (auto* y = cnv->gl_list; y; y = y->g_next) {
+            if (pd_class(&y->g_pd) == garray_class) {
+                canReuse = false;
+            } else if (auto* child = pd_checkglist(&y->g_pd); child && !canvas_isabstraction(child)) {
+                hash = combine(hash, getSignature(child, canReuse));
             }
         }
 
-        autoSaveFile.replaceWithText("");
-        FileOutputStream ostream(autoSaveFile);
-        autoSaveTree.writeToStream(ostream);
+        return hash;
     }
 
-    friend class AutosaveHistoryComponent;
+    // Call this with the audio thread locked, and our instance selected
+    static bool isRootCanvas(t_canvas* cnv)
+    {
+        for (auto* x = pd_getcanvaslist(); x; x = x->gl_next) {
+            if (x == cnv)
+                return true;
+        }
+        return false;
+    }
+
+    bool isInternalPatch(File const& patch)
+    {
+        auto const pathName = patch.getFullPathName();
+        return pathName.contains("Documents/plugdata/Abstractions") || pathName.contains("Documents\\plugdata\\Abstractions") || pathName.contains("Documents/plugdata/Documentation") || pathName.contains("Documents\\plugdata\\Documentation") || pathName.contains("Documents/plugdata/Extra") || pathName.contains("Documents\\plugdata\\Extra") || patch.getParentDirectory() == File::getSpecialLocation(File::tempDirectory);
+    }
 };
 
 class AutosaveHistoryComponent : public Component {
@@ -185,9 +498,7 @@ class AutosaveHistoryComponent : public Component {
             openPatch.setColour(TextButton::buttonOnColourId, backgroundColour.contrasting(0.1f));
             openPatch.setColour(ComboBox::outlineColourId, Colours::transparentBlack);
             openPatch.onClick = [this, editor]() {
-                MemoryOutputStream ostream;
-                Base64::convertFromBase64(ostream, patch);
-                auto patch = editor->pd->loadPatch(String::fromUTF8(static_cast<const char*>(ostream.getData()), ostream.getDataSize()), editor);
+                auto patch = editor->pd->loadPatch(this->patch, editor);
                 patch->setTitle(patchPath.fromLastOccurrenceOf("/", false, false));
                 patch->setCurrentFile(File(patchPath));
 
@@ -236,11 +547,11 @@ class AutosaveHistoryComponent : public Component {
     struct ContentComponent : public Component {
         ContentComponent(PluginEditor* editor)
         {
-            for (auto child : Autosave::autoSaveTree) {
+            for (auto child : journal->tree) {
                 addAndMakeVisible(histories.add(new AutoSaveHistory(editor, child)));
             }
 
-            setSize(getWidth(), Autosave::autoSaveTree.getNumChildren() * 64 + 24);
+            setSize(getWidth(), journal->tree.getNumChildren() * 64 + 24);
         }
 
         void resized() override
@@ -252,6 +563,7 @@ class AutosaveHistoryComponent : public Component {
             }
         }
 
+        SharedResourcePointer<AutosaveJournal> journal;
         OwnedArray<AutoSaveHistory> histories;
     };
 
@@ -0,0 +1,222 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_events/juce_events.h>
+#include <BinaryData.h>
+
+#include "BundledFilesystem.h"
+
+// Binary data shouldn't be too big, then the compiler will run out of memory
+// To prevent this, the archive is split into multiple resources, this reads them back as one stream without copying them together
+class SplitResourceInputStream : public InputStream {
+public:
+    SplitResourceInputStream()
+    {
+        while (true) {
+            int size;
+            auto* resource = BinaryData::getNamedResource((String("Filesystem_") + String(static_cast<int>(resources.size())) + "_zip").toRawUTF8(), size);
+
+            if (!resource) {
+                break;
+            }
+
+            resources.push_back({ resource, totalLength });
+            totalLength += size;
+        }
+    }
+
+    int64 getTotalLength() override
+    {
+        return totalLength;
+    }
+
+    bool isExhausted() override
+    {
+        return position >= totalLength;
+    }
+
+    int64 getPosition() override
+    {
+        return position;
+    }
+
+    bool setPosition(int64 newPosition) override
+    {
+        position = jlimit<int64>(0, totalLength, newPosition);
+        return true;
+    }
+
+    int read(void* destBuffer, int maxBytesToRead) override
+    {
+        auto* dest = static_cast<char*>(destBuffer);
+        int numRead = 0;
+
+        while (numRead < maxBytesToRead && position < totalLength) {
+            // Find the last resource that starts at or before our position
+            auto it = std::upper_bound(resources.begin(), resources.end(), position, [](int64 pos, Resource const& resource) {
+                return pos < resource.offset;
+            });
+            --it;
+
+            auto const end = std::next(it) != resources.end() ? std::next(it)->offset : totalLength;
+            auto const numToCopy = static_cast<int>(std::min<int64>(maxBytesToRead - numRead, end - position));
+
+            std::memcpy(dest + numRead, it->data + (position - it->offset), numToCopy);
+            numRead += numToCopy;
+            position += numToCopy;
+        }
+
+        return numRead;
+    }
+
+private:
+    struct Resource {
+        char const* data;
+        int64 offset;
+    };
+
+    std::vector<Resource> resources;
+    int64 totalLength = 0;
+    int64 position = 0;
+};
+
+JUCE_IMPLEMENT_SINGLETON(BundledFilesystem)
+
+BundledFilesystem::BundledFilesystem()
+    : Thread("Filesystem Extractor")
+{
+}
+
+BundledFilesystem::~BundledFilesystem()
+{
+    // If we're interrupted, the marker stays and we start over next time
+    stopThread(-1);
+    clearSingletonInstance();
+}
+
+void BundledFilesystem::initialise()
+{
+    auto const& versionDataDir = ProjectInfo::versionDataDir;
+
+    if (extracting || (versionDataDir.isDirectory() && !extractionMarker.exists()))
+        return;
+
+    versionDataDir.createDirectory();
+    extractionMarker.create();
+
+    archive = std::make_unique<ZipFile>(new SplitResourceInputStream(), true);
+
+    // Patches can be loaded as soon as the first instance exists, and they need the abstractions and externals in Extra to be there
+    // So only the documentation is left for the background
+    for (int i = 0; i < archive->getNumEntries(); i++) {
+        if (!isDocumentation(archive->getEntry(i)->filename) && !extractEntry(i))
+            extractionFailed = true;
+    }
+
+    // Make sure we can link to this before it's filled in
+    versionDataDir.getChildFile("Documentation").createDirectory();
+
+    extracting = true;
+    startThread(Thread::Priority::background);
+}
+
+bool BundledFilesystem::isExtracting() const
+{
+    return extracting;
+}
+
+void BundledFilesystem::callWhenExtracted(std::function<void()> const& callback)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (extracting)
+        pendingCallbacks.push_back(callback);
+    else
+        callback();
+}
+
+void BundledFilesystem::run()
+{
+    for (int i = 0; i < archive->getNumEntries(); i++) {
+        if (threadShouldExit())
+            return;
+
+        if (isDocumentation(archive->getEntry(i)->filename) && !extractEntry(i))
+            extractionFailed = true;
+    }
+
+    archive.reset();
+
+    // Keep the marker when a file couldn't be written, so we try again next time
+    if (!extractionFailed)
+        extractionMarker.deleteFile();
+
+    MessageManager::callAsync([_this = WeakReference<BundledFilesystem>(this)]() {
+        if (!_this)
+            return;
+
+        _this->extracting = false;
+
+        auto callbacks = std::move(_this->pendingCallbacks);
+        _this->pendingCallbacks.clear();
+        for (auto const& callback : callbacks) {
+            callback();
+        }
+    });
+}
+
+bool BundledFilesystem::extractEntry(int index)
+{
+    auto const* entry = archive->getEntry(index);
+    auto target = getTargetFile(entry->filename);
+
+    if (entry->filename.endsWithChar('/'))
+        return target.createDirectory().wasOk();
+
+    target.getParentDirectory().createDirectory();
+
+    std::unique_ptr<InputStream> in(archive->createStreamForEntry(index));
+    if (!in)
+        return false;
+
+    TemporaryFile temporary(target);
+    {
+        FileOutputStream out(temporary.getFile());
+        if (!out.openedOk())
+            return false;
+
+        auto const numWritten = out.writeFromInputStream(*in, -1);
+        out.flush();
+        if (numWritten != entry->uncompressedSize || out.getStatus().failed())
+            return false;
+    }
+
+    if (!temporary.overwriteTargetFileWithTemporary())
+        return false;
+
+    target.setLastModificationTime(entry->fileTime);
+    return true;
+}
+
+bool BundledFilesystem::isDocumentation(String const& entryName)
+{
+    auto const documentationDir = ProjectInfo::versionDataDir.getChildFile("Documentation");
+    auto const target = getTargetFile(entryName);
+    return target == documentationDir || target.isAChildOf(documentationDir);
+}
+
+// The archive contains a "plugdata_version" directory, which becomes the data directory for this version
+File BundledFilesystem::getTargetFile(String const& entryName)
+{
+    auto name = entryName.replaceCharacter('\\', '/');
+    if (name.startsWith("./"))
+        name = name.substring(2);
+
+    if (name == "plugdata_version" || name.startsWith("plugdata_version/"))
+        return ProjectInfo::versionDataDir.getChildFile(name.fromFirstOccurrenceOf("plugdata_version", false, false).trimCharactersAtStart("/"));
+
+    return ProjectInfo::appDataDir.getChildFile(name);
+}
@@ -0,0 +1,49 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "Utility/Config.h"
+
+// Extracts the abstractions, documentation and extra files that are bundled as binary data
+// This only happens on the first launch of a new version. Abstractions and Extra are extracted right away, because patches need them,
+// the documentation is extracted in the background so the first instance doesn't have to wait for it
+// Files are written next to their destination first, and then moved into place, so pd never reads a half written patch
+class BundledFilesystem : public Thread
+    , public DeletedAtShutdown {
+public:
+    BundledFilesystem();
+
+    ~BundledFilesystem() override;
+
+    // Starts extracting if that didn't happen for this version yet, or if it was interrupted last time
+    void initialise();
+
+    bool isExtracting() const;
+
+    // Called on the message thread when the documentation has been extracted, or right away if that already happened
+    void callWhenExtracted(std::function<void()> const& callback);
+
+    JUCE_DECLARE_SINGLETON(BundledFilesystem, false)
+
+private:
+    void run() override;
+
+    // Returns false if the entry couldn't be written
+    bool extractEntry(int index);
+    static File getTargetFile(String const& entryName);
+    static bool isDocumentation(String const& entryName);
+
+    std::unique_ptr<ZipFile> archive;
+    std::atomic<bool> extracting = false;
+    std::atomic<bool> extractionFailed = false;
+    std::vector<std::function<void()>> pendingCallbacks;
+
+    // Exists while extraction is in progress, so we know to start over if plugdata was closed before it finished
+    static inline File const extractionMarker = ProjectInfo::versionDataDir.getChildFile(".extracting");
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(BundledFilesystem)
+};
@@ -81,9 +81,12 @@ public:
         return PluginHostType::getPluginLoadedAs() != AudioProcessor::wrapperType_LV2;
     }
 
+    // Only call this from the message thread, after pd is initialised
+    // The receive symbol is resolved here, so the audio thread never has to read the name
     void setName(String const& newName)
     {
         name = newName;
+        receiveSymbol = processor.generateSymbol(newName);
     }
 
     String getName(int maximumStringLength) const override
@@ -100,6 +103,12 @@ public:
         return name;
     }
 
+    // Returns nullptr until the processor has resolved it after initialising pd
+    t_symbol* getReceiveSymbol() const
+    {
+        return receiveSymbol.load();
+    }
+
     void setEnabled(bool shouldBeEnabled)
     {
         enabled = shouldBeEnabled;
@@ -317,6 +326,8 @@ private:
     String name;
     std::atomic<bool> enabled = false;
 
+    std::atomic<t_symbol*> receiveSymbol = nullptr;
+
     Mode mode;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlugDataParameter)
@@ -519,6 +519,11 @@ public:
     std::function<void(ValueTree&)> onClick =   [](ValueTree&){};
     std::function<void(ValueTree&)> onSelect =   [](ValueTree&){};
     std::function<void(ValueTree&)> onDragStart = [](ValueTree&){};
+
+    // Decides if a node matches the filter string, nodes are also shown when one of their children matches
+    std::function<bool(ValueTree const&, String const&)> matchesFilter = [](ValueTree const& node, String const& filter){
+        return node.getProperty("Name").toString().containsIgnoreCase(filter);
+    };
     
 private:
     
@@ -544,7 +549,7 @@ private:
     bool searchInNode(ValueTreeNodeComponent* node)
     {
         // Check if the current node matches the filterString
-        bool found = filterString.isEmpty() || node->valueTreeNode.getProperty("Name").toString().containsIgnoreCase(filterString);
+        bool found = filterString.isEmpty() || matchesFilter(node->valueTreeNode, filterString);
         
         for (auto* child : node->nodes)
         {